@@ -24,48 +24,40 @@
  * be set to true with the set() method. The test() method returns the
  * value. Does not grow.
  ************************************************************************/
-// generate_classmap(Set, IntToBool, IntArray, BoolArray, int, bool);
+// generate_classmap(Set, IntArray, BoolArray, int, bool);
 class Set : public Object {
 public:
-  bool *vals_ = nullptr;
-  size_t sz_ = 0;    // total capacity
+  Bitset vals_;
   size_t elems_ = 0; // number of elements
 
   /** Creates a set of the same size as the dataframe. **/
   Set(DataFrame *df) : Set(df->nrows()) {}
 
   /** Creates a set of the given size **/
-  Set(size_t sz) : vals_(new bool[sz]), sz_(sz) {
-    for (size_t i = 0; i < sz_; i++) {
-      vals_[i] = false;
-    }
-  }
-
-  ~Set() { delete[] vals_; }
+  Set(size_t sz) : vals_(sz, false) {}
 
   /** Add idx to the set. If an idx is out of bounds, ignore it. **/
   void set(size_t idx) {
-    if (idx >= sz_ || vals_[idx])
+    if (idx >= vals_.size() || vals_.get(idx))
       return;
-    vals_[idx] = true;
+    vals_.set(idx, true);
     elems_++;
   }
 
   /** Is idx in the set?  See comment for set(). */
   bool test(size_t idx) {
-    if (idx >= sz_)
+    if (idx >= vals_.size())
       return false; // ignoring out of bound reads
-    return vals_[idx];
+    return vals_.get(idx);
   }
 
   size_t size() { return elems_; }
-  size_t capacity() { return sz_; }
+  size_t capacity() { return vals_.size(); }
 
-  /** Performs set union in place. */
+  /** Performs set union in place, a word at a time. */
   void union_(Set &from) {
-    for (size_t i = 0; i < from.sz_; i++)
-      if (from.test(i))
-        set(i);
+    vals_.or_with(from.vals_);
+    elems_ = vals_.count();
   }
 };
 
@@ -123,7 +115,9 @@ public:
  * where the pid is the identifier of a project and the uids are the
  * identifiers of the author and committer. If the author is a collaborator
  * of Linus, then the project is added to the set. If the project was
- * already tagged then it is not added to the set of newProjects.
+ * already tagged then it is not added to the set of newProjects. The shared
+ * sets are only read, so clones can tag in parallel; their newProjects are
+ * joined by union.
  *************************************************************************/
 class ProjectsTagger : public Rower {
 public:
@@ -132,7 +126,10 @@ public:
   Set newProjects; // newly tagged collaborator projects
 
   ProjectsTagger(Set &uSet, Set &pSet, DataFrame *proj)
-      : uSet(uSet), pSet(pSet), newProjects(proj) {}
+      : ProjectsTagger(uSet, pSet, proj->nrows()) {}
+
+  ProjectsTagger(Set &uSet, Set &pSet, size_t nprojects)
+      : uSet(uSet), pSet(pSet), newProjects(nprojects) {}
 
   /** The data frame must have at least two integer columns. The newProject
    * set keeps track of projects that were newly tagged (they will have to
@@ -140,13 +137,19 @@ public:
   bool accept(Row &row) override {
     int pid = row.get_int(0);
     int uid = row.get_int(1);
-    if (uSet.test(uid))
-      if (!pSet.test(pid)) {
-        pSet.set(pid);
-        newProjects.set(pid);
-      }
+    if (uSet.test(uid) && !pSet.test(pid))
+      newProjects.set(pid);
     return false;
   }
+
+  void join_delete(Rower *other) override {
+    newProjects.union_(dynamic_cast<ProjectsTagger *>(other)->newProjects);
+    delete other;
+  }
+
+  Rower *clone() override {
+    return new ProjectsTagger(uSet, pSet, newProjects.capacity());
+  }
 };
 
 /***************************************************************************
@@ -155,7 +158,8 @@ public:
  * also committed as an author. The commit dataframe has the form:
  *    pid x uid x uid
  * where the pid is the idefntifier of a project and the uids are the
- * identifiers of the author and committer.
+ * identifiers of the author and committer. Like the ProjectsTagger, it only
+ * reads the shared sets and joins clones by union.
  *************************************************************************/
 class UsersTagger : public Rower {
 public:
@@ -164,19 +168,27 @@ public:
   Set newUsers;
 
   UsersTagger(Set &pSet, Set &uSet, DataFrame *users)
-      : pSet(pSet), uSet(uSet), newUsers(users->nrows()) {}
+      : UsersTagger(pSet, uSet, users->nrows()) {}
+
+  UsersTagger(Set &pSet, Set &uSet, size_t nusers)
+      : pSet(pSet), uSet(uSet), newUsers(nusers) {}
 
   bool accept(Row &row) override {
     int pid = row.get_int(0);
     int uid = row.get_int(1);
-
-    if (pSet.test(pid))
-      if (!uSet.test(uid)) {
-        uSet.set(uid);
-        newUsers.set(uid);
-      }
+    if (pSet.test(pid) && !uSet.test(uid))
+      newUsers.set(uid);
     return false;
   }
+
+  void join_delete(Rower *other) override {
+    newUsers.union_(dynamic_cast<UsersTagger *>(other)->newUsers);
+    delete other;
+  }
+
+  Rower *clone() override {
+    return new UsersTagger(pSet, uSet, newUsers.capacity());
+  }
 };
 
 /*************************************************************************
@@ -262,12 +274,17 @@ public:
     newUsers->distributed_map(upd); // all of the new users are copied to delta.
     delete newUsers;
 
+    // The taggers only read the project and author of each commit.
+    Bitset pid_uid(commits->ncols(), false);
+    pid_uid.set(0, true);
+    pid_uid.set(1, true);
+
     ProjectsTagger ptagger(delta, *pSet, projects);
-    commits->local_map(ptagger); // marking all projects touched by delta
+    commits->local_pmap(ptagger, pid_uid); // marking projects touched by delta
     merge(ptagger.newProjects, "projects-", stage);
     pSet->union_(ptagger.newProjects);
     UsersTagger utagger(ptagger.newProjects, *uSet, users);
-    commits->local_map(utagger);
+    commits->local_pmap(utagger, pid_uid);
     merge(utagger.newUsers, "users-", stage + 1);
     uSet->union_(utagger.newUsers);
     p("    after stage ").p(stage).pln(":");
@@ -90,135 +90,132 @@ public:
   FILE *file_;
 };
 
-/****************************************************************************/
-class Adder : public Rower {
+/****************************************************************************
+ * Counts the occurrences of each word in the first column of a dataframe. A
+ * WordCounter can run at the nodes that store the words, which send back
+ * their counts to be summed.
+ **********************************************************************/
+class WordCounter : public RemoteRower {
 public:
-  SIMap &map_;
-  size_t num_words_seen = 0;
+  SIMap counts_;
 
-  Adder(SIMap &map) : map_(map) {}
+  const char *name() { return "word-counter"; }
 
   bool accept(Row &r) {
     String *word = r.get_string(0);
-    num_words_seen++;
     assert(word != nullptr);
-    int sum = map_.contains_key(word) ? map_.get(word) : 0;
-    map_.put(word, sum + 1);
+    add_(word, 1);
     return false;
   }
-};
 
-/***************************************************************************/
-class Summer : public Writer {
-public:
-  StringArray *words_;
-  IntArray *counts_;
-  size_t index_ = 0;
-
-  Summer(SIMap &map) : words_(map.keys()), counts_(map.values()) {}
-  ~Summer() {
-    delete words_;
-    delete counts_;
+  /** Counts a batch of dictionary encoded words by their codes, so each
+   * distinct word is looked up once per batch instead of once per row. **/
+  void accept_batch(Batch &batch) {
+    DictStringColumn *dict = batch.dict(0);
+    if (dict == nullptr)
+      return Rower::accept_batch(batch);
+    const int *codes = batch.codes(0);
+    const size_t *missing = batch.missing_words(0);
+    int *counts = new int[dict->cardinality()]();
+    size_t bits = Bitset::WORD_BITS;
+    for (size_t i = 0; i < batch.size(); i++) {
+      if (((missing[i / bits] >> (i % bits)) & 1) == 0)
+        counts[codes[i]]++;
+    }
+    for (size_t code = 0; code < dict->cardinality(); code++) {
+      if (counts[code] > 0)
+        add_(dict->decode(code), counts[code]);
+    }
+    delete[] counts;
   }
 
-  void next() { index_++; }
+  /** Adds n occurrences of a word. **/
+  void add_(String *word, int n) {
+    int sum = counts_.contains_key(word) ? counts_.get(word) : 0;
+    counts_.put(word, sum + n);
+  }
 
-  String *k() { return words_->get(index_); }
-  int v() { return counts_->get(index_); }
+  /** The total number of words counted. **/
+  size_t total() {
+    IntArray *counts = counts_.values();
+    size_t total = 0;
+    for (size_t i = 0; i < counts->size(); i++) {
+      total += counts->get(i);
+    }
+    delete counts;
+    return total;
+  }
 
-  bool accept(Row &r) {
-    r.set(0, k()->clone());
-    r.set(1, v());
-    next();
-    return false;
+  /** Serializes the number of distinct words, then each word and count. **/
+  void serialize(Serializer &ser) {
+    StringArray *words = counts_.keys();
+    IntArray *counts = counts_.values();
+    ser.write(words->size());
+    for (size_t i = 0; i < words->size(); i++) {
+      ser.write(words->get(i));
+      ser.write(counts->get(i));
+    }
+    delete words;
+    delete counts;
+  }
+
+  void restore(Deserializer &dser) {
+    size_t n = dser.read_size_t();
+    for (size_t i = 0; i < n; i++) {
+      String *word = String::deserialize(dser);
+      add_(word, dser.read_int());
+      delete word;
+    }
+  }
+
+  /** Sums the counts of another counter into this one. **/
+  void join_delete(Rower *other) {
+    WordCounter *that = dynamic_cast<WordCounter *>(other);
+    StringArray *words = that->counts_.keys();
+    for (size_t i = 0; i < words->size(); i++) {
+      add_(words->get(i), that->counts_.get(words->get(i)));
+    }
+    delete words;
+    delete other;
   }
 
-  bool done() { return index_ >= words_->size(); }
+  WordCounter *clone() { return new WordCounter(); }
 };
 
 /****************************************************************************
  * Calculate a word count for given file:
  *   1) read the data (single node)
- *   2) produce word counts per homed chunks, in parallel
- *   3) combine the results
+ *   2) count the words of each chunk at the node that stores it, in parallel
+ *   3) sum the counts sent back
  **********************************************************author: pmaj ****/
 class WordCount : public Application {
 public:
-  static const size_t BUFSIZE = 1024;
   Key data;
-  SIMap all;
 
   WordCount(size_t idx, Network *net)
-      : Application(idx, net), data("data", 0) {}
-
-  /** The master nodes reads the input, then all of the nodes count. */
-  void run_() override {
-    if (this_node() == 0) {
-      FileReader fr;
-      delete DataFrame::fromVisitor(&data, this_store(), "S", fr);
-    }
-
-    local_count();
-    reduce();
-
-    if (this_node() == 0) {
-      stop_all();
-    }
+      : Application(idx, net), data("data", 0) {
+    this_store()->registry()->add(new WordCounter());
   }
 
-  /** Returns a key for given node. **/
-  Key *mk_key(size_t idx) {
-    StrBuff sb;
-    sb.c("wc-map-").c(idx);
-    Key *k = new Key(sb.get(), idx);
-    p("Created key ").pln(k->key()->c_str());
-    return k;
-  }
-
-  /** Compute word counts on the local node and build a data frame. */
-  void local_count() {
-    DataFrame *words = this_store()->get_and_wait(&data);
-    p("Node ").p(this_node()).pln(": starting local count...");
-    SIMap map;
-    Adder add(map);
-    words->local_map(add);
-    delete words;
-
-    Summer cnt(map);
-    Key *wc_key = mk_key(this_node());
-    delete DataFrame::fromVisitor(wc_key, this_store(), "SI", cnt);
-    delete wc_key;
-
-    p("Node ").p(this_node()).p(" saw ").p(map.size()).pln(" distinct words.");
-    IntArray *totals = map.values();
-    int total = 0;
-    for (size_t i = 0; i < totals->size(); i++) {
-      total += totals->get(i);
-    }
-    p("Node ").p(this_node()).p(" saw ").p(total).pln(" total words.");
-    delete totals;
-  }
-
-  /** Merge the data frames of all nodes */
-  void reduce() {
+  /** The master node reads the input and has every node count the words
+   * it stores; the other nodes only serve its requests. */
+  void run_() override {
     if (this_node() != 0)
       return;
-    pln("Node 0: reducing counts...");
-    SIMap map;
-    Key *own = mk_key(0);
-    merge(this_store()->get(own), map);
-    for (size_t i = 1; i < arg.num_nodes; ++i) { // merge other nodes
-      Key *ok = mk_key(i);
-      merge(this_store()->get_and_wait(ok), map);
-      delete ok;
-    }
-    p("Total distinct words: ").pln(map.size());
-    delete own;
+    FileReader fr;
+    delete DataFrame::fromVisitor(&data, this_store(), "S", fr);
+    count();
+    stop_all();
   }
 
-  void merge(DataFrame *df, SIMap &m) {
-    Adder add(m);
-    df->distributed_map(add);
-    delete df;
+  /** Counts the words at the nodes that store them and sums the counts. */
+  void count() {
+    DataFrame *words = this_store()->get(&data);
+    pln("Node 0: counting at every node...");
+    WordCounter counter;
+    words->owner_map(counter);
+    delete words;
+    p("Total words: ").pln(counter.total());
+    p("Total distinct words: ").pln(counter.counts_.size());
   }
-};
\ No newline at end of file
+};
@@ -15,7 +15,9 @@ public:
 
   /** Creates an application with from the given network. **/
   Application(size_t index, Network *network)
-      : index_(index), network_(network), store_(index, network) {}
+      : index_(index), network_(network), store_(index, network) {
+    store_.cache()->set_budget(arg.cache_mb << 20);
+  }
 
   /** Returns a read-only copy of this node's KV store/idx/net. **/
   KVStore *this_store() { return &store_; }
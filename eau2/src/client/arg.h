@@ -3,11 +3,18 @@
 
 #include "../utils/string.h"
 
+/** The default number of megabytes of chunks a node keeps cached. **/
+static const size_t DEFAULT_CACHE_MB = 64;
+
+/** The default number of chunks a full scan requests ahead of itself. **/
+static const size_t DEFAULT_PREFETCH_DEPTH = 2;
+
 static void usage(const char *arg0) {
   fprintf(stderr,
           "Usage: %s [-ip IPV4_ADDRESS] [-port PORT_NUM] "
           "[-server_ip IPV4_ADDRESS] [-server_port PORT_NUM] "
-          "[-index NUMBER] [-nodes NUMBER] [-app APP_NAME]\n"
+          "[-index NUMBER] [-nodes NUMBER] [-app APP_NAME] "
+          "[-cache_mb MEGABYTES] [-prefetch CHUNKS]\n"
           "Example: %s -ip 102.168.0.1\n"
           "         %s -ip 192.168.1.1 -port 8080\n",
           arg0, arg0, arg0);
@@ -28,6 +35,8 @@ public:
   bool is_server = true;
   char *app = nullptr;
   const char *file = nullptr;
+  size_t cache_mb = DEFAULT_CACHE_MB;
+  size_t prefetch = DEFAULT_PREFETCH_DEPTH;
 
   void parse(int argc, char **argv) {
     for (int i = 1; i < argc; i++) {
@@ -53,6 +62,10 @@ public:
         app = argv[i + 1];
       } else if (eq_("-file", argv[i]) && i + 1 < argc) {
         file = argv[i + 1];
+      } else if (eq_("-cache_mb", argv[i]) && i + 1 < argc) {
+        cache_mb = strtoul(argv[i + 1], NULL, 10);
+      } else if (eq_("-prefetch", argv[i]) && i + 1 < argc) {
+        prefetch = strtoul(argv[i + 1], NULL, 10);
       }
     }
   }
@@ -5,11 +5,27 @@
 
 #include "../store/column.h"
 #include "../store/kv.h"
+#include "../store/predicate.h"
 #include "../utils/queue.h"
 #include "../utils/thread.h"
 
 /** Represents the types of messages a node can send over the network. **/
-enum class MsgKind { Status, Register, Directory, Kill, Get, Put, Reply };
+enum class MsgKind {
+  Status,
+  Register,
+  Directory,
+  Kill,
+  Get,
+  Put,
+  Reply,
+  Ack,
+  MultiGet,
+  MultiPut,
+  MultiReply,
+  Filter,
+  Execute,
+  Result
+};
 
 /** Represents a message.
  *  @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
@@ -270,6 +286,215 @@ public:
   }
 };
 
+/** Represents an acknowledgement that the request with the same id has been
+ * carried out.
+ * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
+class Ack : public Message {
+public:
+  Ack() { kind_ = MsgKind::Ack; }
+};
+
+/** Serializes an array of keys (count first). **/
+void serialize_keys(Serializer &ser, KeyArray *keys) {
+  ser.write(keys->size());
+  for (size_t i = 0; i < keys->size(); i++) {
+    keys->get(i)->serialize(ser);
+  }
+}
+
+/** Deserializes an array of keys written by serialize_keys. **/
+KeyArray *deserialize_keys(Deserializer &dser) {
+  KeyArray *keys = new KeyArray();
+  size_t len = dser.read_size_t();
+  for (size_t i = 0; i < len; i++) {
+    keys->push_back(Key::deserialize(dser));
+  }
+  return keys;
+}
+
+/** Serializes an array of values (count first). **/
+void serialize_values(Serializer &ser, ValueArray *values) {
+  ser.write(values->size());
+  for (size_t i = 0; i < values->size(); i++) {
+    values->get(i)->serialize(ser);
+  }
+}
+
+/** Deserializes an array of values written by serialize_values. **/
+ValueArray *deserialize_values(Deserializer &dser) {
+  ValueArray *values = new ValueArray();
+  size_t len = dser.read_size_t();
+  for (size_t i = 0; i < len; i++) {
+    values->push_back(Value::deserialize(dser));
+  }
+  return values;
+}
+
+/** Deletes an array of objects along with everything in it. **/
+void delete_all(Array *arr) {
+  if (arr == nullptr)
+    return;
+  for (size_t i = 0; i < arr->size(); i++) {
+    delete arr->get(i);
+  }
+  delete arr;
+}
+
+/** Represents a request for the values of many keys that all live on the
+ * target node. The reply carries the values in the same order.
+ * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
+class MultiGet : public Message {
+public:
+  KeyArray *keys_ = nullptr; // owned, along with every key inside
+
+  MultiGet() { kind_ = MsgKind::MultiGet; }
+  MultiGet(KeyArray *keys) : MultiGet() { keys_ = keys; }
+  ~MultiGet() { delete_all(keys_); }
+
+  KeyArray *keys() { return keys_; }
+
+  void serialize(Serializer &ser) {
+    Message::serialize(ser);
+    serialize_keys(ser, keys_);
+  }
+
+  MultiGet *deserialize(Deserializer &dser) {
+    Message::deserialize(dser);
+    keys_ = deserialize_keys(dser);
+    return this;
+  }
+};
+
+/** Represents many key and value pairs travelling together. A MultiPut
+ * stores them at the target node, a MultiReply answers a MultiGet.
+ * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
+class MultiPut : public Message {
+public:
+  KeyArray *keys_ = nullptr;     // owned, along with every key inside
+  ValueArray *values_ = nullptr; // owned, along with every value inside
+
+  MultiPut() { kind_ = MsgKind::MultiPut; }
+  MultiPut(KeyArray *keys, ValueArray *values) : MultiPut() {
+    keys_ = keys;
+    values_ = values;
+  }
+  ~MultiPut() {
+    delete_all(keys_);
+    delete_all(values_);
+  }
+
+  KeyArray *keys() { return keys_; }
+  ValueArray *values() { return values_; }
+
+  /** Takes ownership of the value at the given index. **/
+  Value *steal_value(size_t index) {
+    Value *hold = values_->get(index);
+    values_->Array::set(index, nullptr);
+    return hold;
+  }
+
+  void serialize(Serializer &ser) {
+    Message::serialize(ser);
+    serialize_keys(ser, keys_);
+    serialize_values(ser, values_);
+  }
+
+  MultiPut *deserialize(Deserializer &dser) {
+    Message::deserialize(dser);
+    keys_ = deserialize_keys(dser);
+    values_ = deserialize_values(dser);
+    return this;
+  }
+};
+
+/** Represents the answer to a MultiGet.
+ * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
+class MultiReply : public MultiPut {
+public:
+  MultiReply() { kind_ = MsgKind::MultiReply; }
+  MultiReply(KeyArray *keys, ValueArray *values) : MultiReply() {
+    keys_ = keys;
+    values_ = values;
+  }
+};
+
+/** Asks the node storing the columns of a chunk for only the rows that
+ * satisfy a predicate. It is answered, once every column is stored, by a
+ * MultiReply holding the same keys and the filtered columns.
+ * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
+class Filter : public MultiGet {
+public:
+  Predicate *pred_ = nullptr; // owned
+
+  Filter() { kind_ = MsgKind::Filter; }
+  Filter(KeyArray *keys, Predicate *pred) : Filter() {
+    keys_ = keys;
+    pred_ = pred;
+  }
+  ~Filter() { delete pred_; }
+
+  Predicate *pred() { return pred_; }
+
+  void serialize(Serializer &ser) {
+    MultiGet::serialize(ser);
+    pred_->serialize(ser);
+  }
+
+  Filter *deserialize(Deserializer &dser) {
+    MultiGet::deserialize(dser);
+    pred_ = Predicate::deserialize(dser);
+    return this;
+  }
+};
+
+/** Asks a node to run a registered RemoteRower over the chunks of a
+ * dataframe that it stores. The rower starts out fresh and is answered by a
+ * Result holding its final state.
+ * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
+class Execute : public Message {
+public:
+  Key *key_ = nullptr;      // owned; where the dataframe is stored
+  String *rower_ = nullptr; // owned; the name the rower is registered under
+
+  Execute() { kind_ = MsgKind::Execute; }
+  Execute(Key *key, String *rower) : Execute() {
+    key_ = key;
+    rower_ = rower;
+  }
+  ~Execute() {
+    delete key_;
+    delete rower_;
+  }
+
+  Key *key() { return key_; }
+  String *rower() { return rower_; }
+
+  void serialize(Serializer &ser) {
+    Message::serialize(ser);
+    key_->serialize(ser);
+    rower_->serialize(ser);
+  }
+
+  Execute *deserialize(Deserializer &dser) {
+    Message::deserialize(dser);
+    key_ = Key::deserialize(dser);
+    rower_ = String::deserialize(dser);
+    return this;
+  }
+};
+
+/** Answers an Execute with the final state of the rower that ran, stored as
+ * the value under the dataframe's key.
+ * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
+class Result : public Reply {
+public:
+  Result() { kind_ = MsgKind::Result; }
+  Result(Key *key, Value *state) : Result() {
+    key_ = key;
+    value_ = state;
+  }
+};
+
 /** Acquires a message from a deserializer object. **/
 Message *Message::from(Deserializer &dser) {
   MsgKind kind = static_cast<MsgKind>(dser.peek_size_t());
@@ -296,6 +521,27 @@ Message *Message::from(Deserializer &dser) {
   case MsgKind::Reply:
     msg = new Reply();
     break;
+  case MsgKind::Ack:
+    msg = new Ack();
+    break;
+  case MsgKind::MultiGet:
+    msg = new MultiGet();
+    break;
+  case MsgKind::MultiPut:
+    msg = new MultiPut();
+    break;
+  case MsgKind::MultiReply:
+    msg = new MultiReply();
+    break;
+  case MsgKind::Filter:
+    msg = new Filter();
+    break;
+  case MsgKind::Execute:
+    msg = new Execute();
+    break;
+  case MsgKind::Result:
+    msg = new Result();
+    break;
   default:
     assert(false);
   }
@@ -2,7 +2,11 @@
 // lang:CwC
 
 #include <arpa/inet.h>
+#include <fcntl.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
@@ -11,27 +15,273 @@
 // Incoming connections queue size
 static size_t CONN_QUEUE_SIZE = 100;
 
-/** Represents the information needed to identify a node. **/
+// How many times we try to (re)connect to a peer before giving up.
+static const size_t CONNECT_ATTEMPTS = 5;
+
+/** Represents the information needed to identify a node. Each node also owns
+ * the long-lived outgoing stream used for every message sent to it. **/
 class NodeInfo : public Object {
 public:
   size_t id;
   sockaddr_in address;
+  int sock_ = -1; // persistent connection to this node, -1 if not connected
+  Lock lock_;     // serializes writers on sock_
+
+  ~NodeInfo() { disconnect(); }
+
+  /** Opens the stream to this node if it is not currently open. Returns
+   * whether or not the node is connected. **/
+  bool connect_() {
+    if (sock_ >= 0)
+      return true;
+    for (size_t i = 0; i < CONNECT_ATTEMPTS; i++) {
+      int sock = socket(AF_INET, SOCK_STREAM, 0);
+      assert(sock >= 0);
+      if (connect(sock, (sockaddr *)&address, sizeof(address)) == 0) {
+        int opt = 1;
+        setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+        sock_ = sock;
+        return true;
+      }
+      close(sock);
+      Thread::sleep(10 * (i + 1));
+    }
+    return false;
+  }
+
+  /** Closes the stream to this node (if any). **/
+  void disconnect() {
+    if (sock_ < 0)
+      return;
+    close(sock_);
+    sock_ = -1;
+  }
 };
 
 /** Here's an array of node information. **/
 generate_object_classarray(NodeInfoArray, NodeInfo);
 
-/** IP based network. Each node is classified by an address and id. **/
+/** Writes all len bytes to the given socket. Returns false on failure. **/
+static bool send_fully(int sock, const char *bytes, size_t len,
+                       int flags = 0) {
+  while (len > 0) {
+    ssize_t sent = send(sock, bytes, len, MSG_NOSIGNAL | flags);
+    if (sent <= 0)
+      return false;
+    bytes += sent;
+    len -= sent;
+  }
+  return true;
+}
+
+/** An incoming stream along with the frame currently being reassembled from
+ * it. Frames are a size_t length followed by that many bytes.
+ * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
+class Connection : public Object {
+public:
+  int sock_;
+  size_t size_ = 0;         // length of the current frame
+  size_t header_read_ = 0;  // bytes of the length read so far
+  char *payload_ = nullptr; // owned; the current frame's bytes
+  size_t payload_read_ = 0; // bytes of the payload read so far
+
+  Connection(int sock) : sock_(sock) {}
+  ~Connection() {
+    delete[] payload_;
+    close(sock_);
+  }
+
+  /** Two connections are the same if they wrap the same socket. **/
+  bool equals(Object *other) {
+    Connection *that = dynamic_cast<Connection *>(other);
+    return that != nullptr && that->sock_ == sock_;
+  }
+
+  /** Reads whatever is available (up to budget bytes) into the current frame.
+   * Returns false if the stream has been closed or failed. A finished
+   * message is handed back through msg, which is otherwise nullptr. **/
+  bool read_some(size_t budget, Message *&msg) {
+    msg = nullptr;
+    ssize_t got;
+    if (header_read_ < sizeof(size_t)) {
+      char *header = reinterpret_cast<char *>(&size_);
+      got = read(sock_, header + header_read_, sizeof(size_t) - header_read_);
+      if (got <= 0)
+        return got < 0 && retry_later_();
+      header_read_ += got;
+      if (header_read_ < sizeof(size_t))
+        return true;
+      payload_ = new char[size_];
+      payload_read_ = 0;
+    }
+
+    size_t want = Util::min(size_ - payload_read_, budget);
+    if (want > 0) {
+      got = read(sock_, payload_ + payload_read_, want);
+      if (got <= 0)
+        return got < 0 && retry_later_();
+      payload_read_ += got;
+    }
+
+    if (payload_read_ == size_) {
+      msg = finish_();
+    }
+    return true;
+  }
+
+  /** Whether a failed read only has to be tried again: nothing was there
+   * yet, or a signal interrupted it. The socket is watched level-triggered,
+   * so it is reported again while bytes are waiting. **/
+  static bool retry_later_() {
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+  }
+
+  /** Turns the completed payload into a message and resets for the next
+   * frame. **/
+  Message *finish_() {
+    Buffer *chars = new Buffer();
+    chars->adopt(payload_, size_);
+    payload_ = nullptr;
+    header_read_ = 0;
+    payload_read_ = 0;
+
+    Deserializer dser(chars);
+    return Message::from(dser);
+  }
+};
+
+generate_object_classarray(ConnectionArray, Connection);
+
+/** Single-threaded event loop that multiplexes every incoming stream of a node
+ * with epoll. Streams are non-blocking and each one only gets a bounded read
+ * per wakeup, so a large frame from one peer cannot hold up small frames from
+ * the others. Completed messages are pushed onto the inbox.
+ * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
+class NetworkReactor : public Thread {
+public:
+  int epoll_;
+  Connection listener_;  // duplicate of the node's listening socket
+  Connection waker_;     // eventfd used to stop the loop
+  ConnectionArray open_; // owned; every accepted stream
+  ConcurrentMessageQueue &inbox_;
+
+  NetworkReactor(int listen_sock, ConcurrentMessageQueue &inbox)
+      : listener_(dup(listen_sock)), waker_(eventfd(0, EFD_NONBLOCK)),
+        inbox_(inbox) {
+    epoll_ = epoll_create1(0);
+    assert(epoll_ >= 0 && waker_.sock_ >= 0);
+    // Accepting drains the backlog until it would block.
+    int flags = fcntl(listener_.sock_, F_GETFL);
+    fcntl(listener_.sock_, F_SETFL, flags | O_NONBLOCK);
+    watch_(&listener_);
+    watch_(&waker_);
+  }
+
+  ~NetworkReactor() { close(epoll_); }
+
+  /** Wakes the loop up and makes it exit. **/
+  void stop() {
+    uint64_t one = 1;
+    ssize_t res = write(waker_.sock_, &one, sizeof(one));
+    assert(res == sizeof(one));
+  }
+
+  /** Registers a connection for read readiness. **/
+  void watch_(Connection *conn) {
+    epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = conn;
+    int res = epoll_ctl(epoll_, EPOLL_CTL_ADD, conn->sock_, &ev);
+    assert(res == 0);
+  }
+
+  /** Accepts every pending stream on the listening socket. **/
+  void accept_() {
+    while (true) {
+      int sock = accept4(listener_.sock_, nullptr, nullptr, SOCK_NONBLOCK);
+      if (sock < 0)
+        return;
+      int opt = 1;
+      setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+      Connection *conn = new Connection(sock);
+      open_.push_back(conn);
+      watch_(conn);
+    }
+  }
+
+  /** Services the readiness of one peer stream. **/
+  void service_(Connection *conn) {
+    Message *msg = nullptr;
+    if (!conn->read_some(READ_BUDGET, msg)) {
+      epoll_ctl(epoll_, EPOLL_CTL_DEL, conn->sock_, nullptr);
+      delete open_.remove(open_.index_of(conn));
+      return;
+    }
+    if (msg != nullptr) {
+      inbox_.push(msg);
+    }
+  }
+
+  /** Runs the loop until stop() is called, then closes every stream. **/
+  void run() {
+    epoll_event events[MAX_EVENTS];
+    bool running = true;
+    while (running) {
+      int n = epoll_wait(epoll_, events, MAX_EVENTS, -1);
+      for (int i = 0; i < n; i++) {
+        Connection *conn = static_cast<Connection *>(events[i].data.ptr);
+        if (conn == &waker_) {
+          running = false;
+        } else if (conn == &listener_) {
+          accept_();
+        } else {
+          service_(conn);
+        }
+      }
+    }
+
+    // Hang up on every stream that is still open.
+    for (size_t i = 0; i < open_.size(); i++) {
+      delete open_.get(i);
+    }
+    open_.clear();
+  }
+
+  // Max bytes read off of one stream per wakeup.
+  static const size_t READ_BUDGET = 64 * 1024;
+  // Max readiness events handled per epoll_wait.
+  static const int MAX_EVENTS = 64;
+};
+/** IP based network. Each node is classified by an address and id. Messages
+ * travel over one persistent stream per peer; the first message to a peer
+ * opens the stream and later messages reuse it. Incoming streams are
+ * serviced by a NetworkReactor which feeds receive_msg(). **/
 class NetworkIP : public Network {
 public:
   NodeInfoArray node_information_;
   size_t index_;
-  int socket_;
+  int socket_ = -1;
   sockaddr_in address_;
   size_t msg_id = 0;
   size_t num_nodes_ = 1;
 
-  ~NetworkIP() { close(socket_); }
+  ConcurrentMessageQueue inbox_; // fully received messages
+  NetworkReactor *reactor_ = nullptr;
+
+  ~NetworkIP() {
+    for (size_t i = 0; i < node_information_.size(); i++) {
+      delete node_information_.get(i);
+    }
+    if (reactor_ != nullptr) {
+      reactor_->stop();
+      reactor_->join();
+      delete reactor_;
+    }
+    close(socket_);
+    while (inbox_.size() > 0) {
+      delete inbox_.pop();
+    }
+  }
 
   size_t index() { return index_; }
 
@@ -58,10 +308,12 @@ public:
     for (size_t i = 1; i < num_nodes_; i++) {
       Register *reg = dynamic_cast<Register *>(receive_msg());
       NodeInfo *info = node_information_.get(reg->sender());
+      info->id = reg->sender();
       info->address.sin_family = AF_INET;
       info->address.sin_addr = reg->address_.sin_addr;
       info->address.sin_port = htons(reg->port_);
       p("Node #").p(i).pln(" registered!");
+      delete reg;
     }
 
     // Initialize the directory with matching information.
@@ -106,6 +358,7 @@ public:
     num_nodes_ = dir->clients();
     for (size_t i = 1; i < num_nodes_; i++) {
       NodeInfo *node = new NodeInfo();
+      node->id = i;
       node->address.sin_family = AF_INET;
       node->address.sin_port = htons(dir->port(i));
       inet_pton(AF_INET, dir->address(i)->c_str(), &node->address.sin_addr);
@@ -115,9 +368,10 @@ public:
     p("Registered! Found ").p(num_nodes_ - 1).pln(" other nodes.");
   }
 
-  /** Binds this node to an available socket. **/
+  /** Binds this node to an available socket and starts accepting streams. **/
   void create_socket_(String *ip, size_t port) {
-    assert((socket_ = socket(AF_INET, SOCK_STREAM, 0)) >= 0);
+    socket_ = socket(AF_INET, SOCK_STREAM, 0);
+    assert(socket_ >= 0);
     int opt = 1;
     int res = setsockopt(socket_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
     assert(res == 0);
@@ -125,31 +379,42 @@ public:
     address_.sin_port = htons(port);
     inet_pton(AF_INET, ip->c_str(), &address_.sin_addr);
     size_t addrlen = sizeof(address_);
-    assert(bind(socket_, (sockaddr *)&address_, addrlen) >= 0);
-    assert(listen(socket_, CONN_QUEUE_SIZE) >= 0);
+    res = bind(socket_, (sockaddr *)&address_, addrlen);
+    assert(res >= 0);
+    res = listen(socket_, CONN_QUEUE_SIZE);
+    assert(res >= 0);
+
+    reactor_ = new NetworkReactor(socket_, inbox_);
+    reactor_->start();
   }
 
-  /** Sends a reference of a message. Cannot delete it. **/
-  void send_msg_(Message &msg) {
-    // Connect to target
-    NodeInfo *target = node_information_.get(msg.target());
-    int sock = socket(AF_INET, SOCK_STREAM, 0);
-    size_t addrlen = sizeof(target->address);
-    assert(connect(sock, (sockaddr *)&target->address, addrlen) >= 0);
+  /** Writes a serialized message as one frame (its length, then its bytes)
+   * onto the given stream. **/
+  bool send_frame_(int sock, Serializer &ser) {
+    size_t size = ser.length();
+    // Hold the header back so that it leaves in the same packet as the body.
+    if (!send_fully(sock, reinterpret_cast<char *>(&size), sizeof(size_t),
+                    MSG_MORE))
+      return false;
+    return send_fully(sock, ser.data()->data(), size);
+  }
 
-    // Serialize the message
+  /** Sends a reference of a message. Cannot delete it. The stream to the
+   * target is opened on first use and reopened if the peer hung up. **/
+  void send_msg_(Message &msg) {
     Serializer ser;
     ser.write(&msg);
 
-    size_t size = ser.length();
-    send(sock, &size, sizeof(size_t), 0);
-    for (size_t i = 0; i < ser.num_chunks(); i++) {
-      if (i + 1 == ser.num_chunks()) {
-        send(sock, ser.get_chunk(i), size % CHUNK_SIZE, 0);
-      } else {
-        send(sock, ser.get_chunk(i), CHUNK_SIZE, 0);
-      }
+    NodeInfo *target = node_information_.get(msg.target());
+    target->lock_.lock();
+    bool sent = target->connect_() && send_frame_(target->sock_, ser);
+    if (!sent) {
+      // The stream went stale, so retry once on a fresh connection.
+      target->disconnect();
+      sent = target->connect_() && send_frame_(target->sock_, ser);
     }
+    target->lock_.unlock();
+    assert(sent && "Failed to send message");
   }
 
   /** Sends a message pointer. Consumes the message. **/
@@ -160,33 +425,6 @@ public:
     }
   }
 
-  /** Receives a message. **/
-  Message *receive_msg() {
-    sockaddr_in sender;
-    socklen_t addrlen = sizeof(sender);
-    int req = accept(socket_, (sockaddr *)&sender, &addrlen);
-
-    size_t size = 0;
-    if (read(req, &size, sizeof(size_t)) == 0)
-      assert(false && "Failed to read");
-    CharArray *chars = new CharArray();
-    size_t read_so_far = 0;
-    char *buffer = new char[CHUNK_SIZE];
-    while (read_so_far != size) {
-      size_t left_to_go = size - read_so_far;
-      if (left_to_go <= CHUNK_SIZE) {
-        read_so_far += read(req, buffer, left_to_go);
-      } else {
-        read_so_far += read(req, buffer, CHUNK_SIZE);
-      }
-
-      for (size_t i = 0; i < CHUNK_SIZE && i < left_to_go; i++) {
-        chars->push_back(buffer[i]);
-      }
-    }
-
-    delete[] buffer;
-    Deserializer dser(chars);
-    return Message::from(dser);
-  }
-};
\ No newline at end of file
+  /** Receives a message from any of the incoming streams. **/
+  Message *receive_msg() { return inbox_.pop(); }
+};
@@ -5,7 +5,7 @@
 #include "network.h"
 
 /** Mapping from String to size_t **/
-generate_classmap(SSTMap, SSTNode, StringArray, SizeTArray, String *, size_t);
+generate_classmap(SSTMap, StringArray, SizeTArray, String *, size_t);
 
 /** Represents a concurrent map from String to size_t. **/
 class ConcurrentSSTMap : public SSTMap {
@@ -0,0 +1,211 @@
+#pragma once
+// lang: CwC
+
+#include "../client/arg.h"
+#include "../utils/map.h"
+#include "../utils/thread.h"
+#include "future.h"
+#include "kv.h"
+
+/** A cached chunk, linked into its cache's recency list.
+ * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
+class CacheEntry : public Object {
+public:
+  Key *key_;                    // owned
+  Value *value_;                // owned
+  CacheEntry *newer_ = nullptr; // external; the next most recently used
+  CacheEntry *older_ = nullptr; // external; the next least recently used
+
+  CacheEntry(Key *key, Value *value) : key_(key), value_(value) {}
+  ~CacheEntry() {
+    delete key_;
+    delete value_;
+  }
+};
+
+/** Mapping from a chunk's key to its cache entry. **/
+generate_classmap(CacheMap, KeyArray, Array, Key *, CacheEntry *);
+
+/** A byte budgeted, least recently used cache of the chunks this node has
+ * fetched from other nodes. It is shared by every DataFrame on the node, so
+ * repeated passes over the same remote data do not go back to the network.
+ * Values are immutable and share their blobs, so handing out a cached value
+ * does not copy its bytes. Safe to use from many threads.
+ *
+ * The cache only hears about puts made from this node, which invalidate the
+ * key. A key put again from another node is not seen, so only keys that are
+ * written once, like the chunks of a DataFrame, may be cached.
+ * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
+class ChunkCache : public Object {
+public:
+  Lock lock_;
+  CacheMap entries_;
+  CacheEntry *newest_ = nullptr; // owned, as is the rest of the list
+  CacheEntry *oldest_ = nullptr; // external
+  size_t budget_;                // maximum bytes of values kept
+  size_t bytes_ = 0;
+  size_t hits_ = 0, misses_ = 0, evictions_ = 0;
+
+  ChunkCache() : ChunkCache(DEFAULT_CACHE_MB << 20) {}
+  ChunkCache(size_t budget) : budget_(budget) {}
+
+  ~ChunkCache() {
+    while (newest_ != nullptr) {
+      CacheEntry *next = newest_->older_;
+      delete newest_;
+      newest_ = next;
+    }
+  }
+
+  /** Changes the byte budget, evicting entries until it is met. **/
+  void set_budget(size_t budget) {
+    lock_.lock();
+    budget_ = budget;
+    evict_(0);
+    lock_.unlock();
+  }
+
+  /** Returns a copy of the value cached at key, which the caller owns, or
+   * nullptr if it is not cached. The key is external. **/
+  Value *get(Key *key) {
+    lock_.lock();
+    Value *found = nullptr;
+    if (entries_.contains_key(key)) {
+      CacheEntry *entry = entries_.get(key);
+      unlink_(entry);
+      push_newest_(entry);
+      found = entry->value_->clone();
+      hits_++;
+    } else {
+      misses_++;
+    }
+    lock_.unlock();
+    return found;
+  }
+
+  /** Caches a copy of the value at key, evicting the least recently used
+   * entries to stay within budget. Both arguments are external. Values that
+   * are larger than the whole budget are not cached. **/
+  void put(Key *key, Value *value) {
+    lock_.lock();
+    if (entries_.contains_key(key))
+      drop_(entries_.get(key));
+    if (value->size() <= budget_) {
+      evict_(value->size());
+      CacheEntry *entry = new CacheEntry(key->clone(), value->clone());
+      entries_.put(entry->key_, entry);
+      push_newest_(entry);
+      bytes_ += value->size();
+    }
+    lock_.unlock();
+  }
+
+  /** Drops the value cached at key, if any, since the key is being put
+   * again. The key is external. **/
+  void invalidate(Key *key) {
+    lock_.lock();
+    if (entries_.contains_key(key))
+      drop_(entries_.get(key));
+    lock_.unlock();
+  }
+
+  /** Whether a value is cached at key, without counting a hit or miss. **/
+  bool contains(Key *key) {
+    lock_.lock();
+    bool found = entries_.contains_key(key);
+    lock_.unlock();
+    return found;
+  }
+
+  /** Statistics about the cache, read under its lock. **/
+  size_t hits() { return read_(hits_); }
+  size_t misses() { return read_(misses_); }
+  size_t evictions() { return read_(evictions_); }
+  size_t bytes() { return read_(bytes_); }
+  size_t size() { return read_(entries_.num_elements_); }
+
+  /** Reads a field that other threads may be updating. **/
+  size_t read_(size_t &field) {
+    lock_.lock();
+    size_t value = field;
+    lock_.unlock();
+    return value;
+  }
+
+  /** Evicts the oldest entries until extra more bytes fit in the budget. **/
+  void evict_(size_t extra) {
+    while (oldest_ != nullptr && bytes_ + extra > budget_) {
+      drop_(oldest_);
+      evictions_++;
+    }
+  }
+
+  /** Removes an entry from the cache and deletes it. **/
+  void drop_(CacheEntry *entry) {
+    entries_.remove(entry->key_);
+    unlink_(entry);
+    bytes_ -= entry->value_->size();
+    delete entry;
+  }
+
+  /** Takes an entry out of the recency list. **/
+  void unlink_(CacheEntry *entry) {
+    if (entry->newer_ == nullptr)
+      newest_ = entry->older_;
+    else
+      entry->newer_->older_ = entry->older_;
+    if (entry->older_ == nullptr)
+      oldest_ = entry->newer_;
+    else
+      entry->older_->newer_ = entry->newer_;
+    entry->newer_ = entry->older_ = nullptr;
+  }
+
+  /** Puts an entry at the most recently used end of the list. **/
+  void push_newest_(CacheEntry *entry) {
+    entry->older_ = newest_;
+    if (newest_ != nullptr)
+      newest_->newer_ = entry;
+    newest_ = entry;
+    if (oldest_ == nullptr)
+      oldest_ = entry;
+  }
+};
+
+/** The columns of a chunk that have been requested from another node ahead
+ * of when they are needed. The load of the chunk takes the values straight
+ * from the answer, so they are used even when the cache has no room.
+ * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
+class PendingChunk : public Object {
+public:
+  size_t chunk_;
+  KeyArray *keys_;  // owned, as are the keys
+  Future *request_; // owned; answered by a MultiReply
+
+  PendingChunk(size_t chunk, KeyArray *keys, Future *request)
+      : chunk_(chunk), keys_(keys), request_(request) {}
+
+  ~PendingChunk() {
+    request_->wait();
+    for (size_t i = 0; i < keys_->size(); i++) {
+      delete keys_->get(i);
+    }
+    delete keys_;
+    delete request_;
+  }
+
+  /** Waits for the requested values and hands over the one at key, which
+   * the caller then owns. Returns nullptr if key was not requested or has
+   * already been taken. The key is external. **/
+  Value *take(Key *key) {
+    MultiReply *reply = dynamic_cast<MultiReply *>(request_->reply());
+    for (size_t i = 0; i < keys_->size(); i++) {
+      if (keys_->get(i)->equals(key))
+        return reply->steal_value(i);
+    }
+    return nullptr;
+  }
+};
+
+/** Here's an array of pending chunks. **/
+generate_object_classarray(PendingChunkArray, PendingChunk);
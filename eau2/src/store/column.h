@@ -2,6 +2,9 @@
 #pragma once
 
 #include "../utils/array.h"
+#include "../utils/bitset.h"
+#include "../utils/buffer.h"
+#include "../utils/map.h"
 #include "stdarg.h"
 
 /** Forward declarations to make Column Class compile. **/
@@ -9,6 +12,7 @@ class BoolColumn;
 class IntColumn;
 class FloatColumn;
 class StringColumn;
+class DictStringColumn;
 
 /**************************************************************************
  * Column ::
@@ -22,7 +26,7 @@ class StringColumn;
 class Column : public Object {
 public:
   char type_ = '\0';
-  BoolArray missing_;
+  Bitset missing_; // a set bit marks a missing row
 
   /** Type converters: Return same column under its actual type, or
    *  nullptr if of the wrong type.  */
@@ -52,13 +56,13 @@ public:
   /** Overriding the clone method on object **/
   virtual Column *clone() { return nullptr; }
 
-  /** Serializes this column onto the given serializer object. **/
+  /** Serializes this column onto the given serializer object. The missing
+   * flags are written as a packed bitmap, subclasses follow with their
+   * values. **/
   virtual void serialize(Serializer &ser) {
     ser.write(type_);
     ser.write(size());
-    for (size_t i = 0; i < size(); i++) {
-      ser.write(is_missing(i));
-    }
+    missing_.serialize(ser);
   }
 
   /** Deserializes a column of the correct type. **/
@@ -76,7 +80,7 @@ public:
  */
 class BoolColumn : public Column {
 public:
-  BoolArray vals_;
+  Bitset vals_;
 
   BoolColumn() { type_ = 'B'; }
 
@@ -129,29 +133,19 @@ public:
   /** Gets the hash of this boolean column **/
   size_t hash() { return vals_.hash(); }
 
-  /** Serializes this column onto the given serializer object. **/
+  /** Serializes this column onto the given serializer object. The values
+   * are packed into a bitmap just like the missing flags. **/
   virtual void serialize(Serializer &ser) {
     Column::serialize(ser);
-    for (size_t i = 0; i < size(); i++)
-      if (!is_missing(i))
-        ser.write(get(i));
+    vals_.serialize(ser);
   }
 
   /** Deserializes a BoolColumn from the given deserializer object. **/
   static BoolColumn *deserialize(Deserializer &dser) {
     BoolColumn *bc = new BoolColumn();
-    size_t len = dser.read_size_t();
-    BoolArray missing;
-    for (size_t i = 0; i < len; i++) {
-      missing.push_back(dser.read_bool());
-    }
-    for (size_t i = 0; i < len; i++) {
-      if (missing.get(i)) {
-        bc->push_back_missing();
-      } else {
-        bc->push_back(dser.read_bool());
-      }
-    }
+    dser.read_size_t();
+    bc->missing_.deserialize(dser);
+    bc->vals_.deserialize(dser);
     return bc;
   }
 };
@@ -217,29 +211,19 @@ public:
   /** Gets the hash of this integer column **/
   size_t hash() { return vals_.hash(); }
 
-  /** Serializes this column onto the given serializer object. **/
+  /** Serializes this column onto the given serializer object. The values
+   * (with zeros in missing rows) are written as one raw block. **/
   virtual void serialize(Serializer &ser) {
     Column::serialize(ser);
-    for (size_t i = 0; i < size(); i++)
-      if (!is_missing(i))
-        ser.write(get(i));
+    vals_.serialize_raw(ser);
   }
 
   /** Deserializes a IntColumn from the given deserializer object. **/
   static IntColumn *deserialize(Deserializer &dser) {
     IntColumn *ic = new IntColumn();
     size_t len = dser.read_size_t();
-    BoolArray missing;
-    for (size_t i = 0; i < len; i++) {
-      missing.push_back(dser.read_bool());
-    }
-    for (size_t i = 0; i < len; i++) {
-      if (missing.get(i)) {
-        ic->push_back_missing();
-      } else {
-        ic->push_back(dser.read_int());
-      }
-    }
+    ic->missing_.deserialize(dser);
+    ic->vals_.deserialize_raw(dser, len);
     return ic;
   }
 };
@@ -306,49 +290,61 @@ public:
   /** Gets the hash of this float column **/
   size_t hash() { return vals_.hash(); }
 
-  /** Serializes this column onto the given serializer object. **/
+  /** Serializes this column onto the given serializer object. The values
+   * (with zeros in missing rows) are written as one raw block. **/
   virtual void serialize(Serializer &ser) {
     Column::serialize(ser);
-    for (size_t i = 0; i < size(); i++)
-      if (!is_missing(i))
-        ser.write(get(i));
+    vals_.serialize_raw(ser);
   }
 
   /** Deserializes a FloatColumn from the given deserializer object. **/
   static FloatColumn *deserialize(Deserializer &dser) {
     FloatColumn *fc = new FloatColumn();
     size_t len = dser.read_size_t();
-    BoolArray missing;
-    for (size_t i = 0; i < len; i++) {
-      missing.push_back(dser.read_bool());
-    }
-    for (size_t i = 0; i < len; i++) {
-      if (missing.get(i)) {
-        fc->push_back_missing();
-      } else {
-        fc->push_back(dser.read_float());
-      }
-    }
+    fc->missing_.deserialize(dser);
+    fc->vals_.deserialize_raw(dser, len);
     return fc;
   }
 };
 
+/** How many rows are sampled to guess whether a column has few distinct
+ * strings. A power of two. **/
+static const size_t DICT_SAMPLE_ROWS = 256;
+
+/** How many views of rows a StringColumn allocates at a time. **/
+static const size_t VIEW_BLOCK_ROWS = 64;
+
+/** Maps a row to the String that was set there. **/
+generate_classmap(RowStringMap, SizeTArray, StringArray, size_t, String *);
+
 /*************************************************************************
  * StringColumn::
- * Holds string pointers. The strings are external.  Nullptr is a valid
- * value.
+ * Holds strings. Nullptr is a valid value.
  *
- * A StringColumn owns all of the Strings inside of it. This means that
- * we clone Strings if they've been passed to an external-accepting
- * function.
+ * The characters of every present string, each with its terminator, are
+ * copied into one arena, and offsets_ records where each row starts in it;
+ * a missing row takes no characters. Until set() is called the arena is
+ * exactly what the column sends, and a column costs a few allocations
+ * instead of a String per row. get() returns a view into the arena, which
+ * stays valid until the next push_back moves the arena. Strings given to
+ * set() are kept whole, in a map by row.
  *
  * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu
  */
 class StringColumn : public Column {
 public:
-  StringArray vals_;
+  Buffer chars_;                    // the characters of the rows, terminated
+  SizeTArray offsets_;              // where each row starts, then the end
+  Bitset adopted_;                  // rows holding a string given to set()
+  RowStringMap strings_;            // owned values; row -> string set there
+  bool edited_ = false;             // whether set() has changed any row
+  String **view_blocks_ = nullptr;  // owned; views of rows, made on demand
+  size_t num_view_blocks_ = 0;
 
-  StringColumn() { type_ = 'S'; }
+  StringColumn() {
+    type_ = 'S';
+    offsets_.push_back(0);
+  }
 
   /** This constructor clones its arguments.  **/
   StringColumn(int n, ...) : StringColumn() {
@@ -364,97 +360,446 @@ public:
     va_end(vl);
   }
 
-  /** A String has ownership over all of its contents. Therefore,
-   * before we delete it, we need to delete all the Strings it contains. **/
+  /** The column owns its views and the strings it was given. **/
   ~StringColumn() {
-    for (size_t i = 0; i < vals_.size(); i++) {
-      delete vals_.get(i);
+    StringArray *strings = strings_.values();
+    for (size_t i = 0; i < strings->size(); i++) {
+      delete strings->get(i);
+    }
+    delete strings;
+    for (size_t i = 0; i < num_view_blocks_; i++) {
+      delete[] view_blocks_[i];
     }
+    delete[] view_blocks_;
   }
 
   /** Casts this column as itself **/
   StringColumn *as_string() { return this; }
 
-  /** Returns the string at idx; undefined on invalid idx.*/
-  String *get(size_t idx) { return vals_.get(idx); }
+  /** Returns the string at idx, owned by the column; undefined on invalid
+   * idx. A view into the arena is only valid until the next push_back; a
+   * string given to set() lives until the row is set again. **/
+  virtual String *get(size_t idx) {
+    assert(idx < size());
+    if (is_missing(idx))
+      return nullptr;
+    if (adopted_.get(idx))
+      return strings_.get(idx);
+    String *view = view_(idx);
+    view->view(chars_.data() + offsets_.get(idx), length_at(idx));
+    return view;
+  }
+
+  /** The view kept for row idx, allocating its block if needed. **/
+  String *view_(size_t idx) {
+    size_t block = idx / VIEW_BLOCK_ROWS;
+    if (block >= num_view_blocks_) {
+      size_t grown = Util::max(block + 1, 2 * num_view_blocks_);
+      String **blocks = new String *[grown]();
+      for (size_t i = 0; i < num_view_blocks_; i++) {
+        blocks[i] = view_blocks_[i];
+      }
+      delete[] view_blocks_;
+      view_blocks_ = blocks;
+      num_view_blocks_ = grown;
+    }
+    if (view_blocks_[block] == nullptr)
+      view_blocks_[block] = new String[VIEW_BLOCK_ROWS];
+    return &view_blocks_[block][idx % VIEW_BLOCK_ROWS];
+  }
+
+  /** The terminated characters of the present string at idx. They belong
+   * to the column and may move when a row is added. **/
+  virtual char *chars_at(size_t idx) {
+    if (adopted_.get(idx))
+      return strings_.get(idx)->c_str();
+    return chars_.data() + offsets_.get(idx);
+  }
+
+  /** The number of characters of the present string at idx. **/
+  virtual size_t length_at(size_t idx) {
+    if (adopted_.get(idx))
+      return strings_.get(idx)->size();
+    return offsets_.get(idx + 1) - offsets_.get(idx) - 1;
+  }
 
   /** Acquire ownership of the string. Out of bound idx is undefined.
-   * Since a StrColumn clones */
-  void set(size_t idx, String *val) {
-    delete vals_.set(idx, val);
+   * Deletes the string that was set at the row before, if any. **/
+  virtual void set(size_t idx, String *val) {
+    assert(idx < size());
     missing_.set(idx, val == nullptr);
+    adopted_.set(idx, val != nullptr);
+    edited_ = true;
+    if (strings_.contains_key(idx))
+      delete strings_.remove(idx);
+    if (val != nullptr)
+      strings_.put(idx, val);
   }
 
-  size_t size() { return vals_.size(); }
+  size_t size() { return offsets_.size() - 1; }
 
-  /** Since Strings are external unless otherwise stated, we make a clone
-   * so that we can manage its memory. **/
+  /** Strings are external unless otherwise stated; their characters are
+   * copied into the column. **/
   virtual void push_back(String *s) {
-    if (s == nullptr) {
+    if (s == nullptr)
       push_back_missing();
-    } else {
-      missing_.push_back(false);
-      vals_.push_back(s->clone());
-    }
+    else
+      push_chars_(s->c_str(), s->size());
   };
 
-  /** Steals this string on push back, used to avoid cloning. **/
-  void push_back_steal_(String *s) {
-    missing_.push_back(false);
-    vals_.push_back(s);
+  /** Takes ownership of this string on push back. **/
+  virtual void push_back_steal_(String *s) {
+    push_back(s);
+    delete s;
   }
 
   /** Push back a dummy on missing **/
   void push_back_missing() {
     Column::push_back_missing();
-    vals_.push_back(nullptr);
+    adopted_.push_back(false);
+    offsets_.push_back(chars_.size());
+  }
+
+  /** Copies len characters, and a terminator, into the arena as a new
+   * row. **/
+  void push_chars_(const char *cstr, size_t len) {
+    missing_.push_back(false);
+    adopted_.push_back(false);
+    chars_.append(cstr, len);
+    chars_.push_back('\0');
+    offsets_.push_back(chars_.size());
   }
 
   /** Object methods to satisfy requirement of being an object. **/
   StringColumn *clone() {
     StringColumn *sc = new StringColumn();
+    sc->chars_.reserve(chars_.size());
     for (size_t i = 0; i < size(); i++) {
-      sc->push_back(get(i));
+      if (is_missing(i))
+        sc->push_back_missing();
+      else
+        sc->push_chars_(chars_at(i), length_at(i));
     }
     return sc;
   }
 
-  /** Does the given string column match the given object. **/
-  bool equals(Object *o) {
+  /** Does the given string column match the given object. Compares the
+   * strings themselves, so plain and dictionary columns can be equal. **/
+  virtual bool equals(Object *o) {
     StringColumn *that = dynamic_cast<StringColumn *>(o);
-    return (that != nullptr) && (vals_.equals(&that->vals_));
+    if (that == nullptr || that->size() != size())
+      return false;
+    for (size_t i = 0; i < size(); i++) {
+      if (is_missing(i) != that->is_missing(i))
+        return false;
+      if (is_missing(i))
+        continue;
+      size_t len = length_at(i);
+      if (len != that->length_at(i) ||
+          memcmp(chars_at(i), that->chars_at(i), len) != 0)
+        return false;
+    }
+    return true;
   }
 
   /** Gets the hash of this string column **/
-  size_t hash() { return vals_.hash(); }
+  virtual size_t hash() {
+    size_t hash = 0;
+    for (size_t i = 0; i < size(); i++) {
+      if (!is_missing(i))
+        hash += Util::hash_bytes(chars_at(i), length_at(i));
+    }
+    return hash;
+  }
+
+  /** Serializes this column onto the given serializer object. Columns with
+   * many repeated strings are sent dictionary encoded instead. **/
+  virtual void serialize(Serializer &ser);
+
+  /** Guesses from an evenly spaced sample of its rows whether the column
+   * repeats its strings enough to be worth dictionary encoding. A sample
+   * holds a larger share of distinct strings than the whole column does, so
+   * only a sample that is almost all distinct rules the column out. Strings
+   * are compared by hash only, and nothing is copied. **/
+  bool mostly_repeated_() {
+    size_t seen[DICT_SAMPLE_ROWS * 2] = {}; // hashes; 0 is an empty slot
+    size_t mask = DICT_SAMPLE_ROWS * 2 - 1;
+    size_t step = Util::max(size() / DICT_SAMPLE_ROWS, (size_t)1);
+    size_t sampled = 0, distinct = 0;
+    for (size_t i = 0; i < size() && sampled < DICT_SAMPLE_ROWS; i += step) {
+      if (is_missing(i))
+        continue;
+      sampled++;
+      size_t h = Util::hash_bytes(chars_at(i), length_at(i));
+      size_t slot = h & mask;
+      while (seen[slot] != 0 && seen[slot] != h)
+        slot = (slot + 1) & mask;
+      if (seen[slot] == 0) {
+        seen[slot] = h;
+        distinct++;
+      }
+    }
+    return distinct * 8 <= sampled * 7;
+  }
 
-  /** Serializes this column onto the given serializer object. **/
-  virtual void serialize(Serializer &ser) {
+  /** The number of characters, with terminators, of the present strings. **/
+  size_t plain_bytes_() {
+    if (!edited_)
+      return chars_.size();
+    size_t bytes = 0;
+    for (size_t i = 0; i < size(); i++)
+      if (!is_missing(i))
+        bytes += length_at(i) + 1;
+    return bytes;
+  }
+
+  /** Serializes the characters of every present string, each with its
+   * terminator, as one block. An unedited arena is that block already. **/
+  void serialize_plain_(Serializer &ser) {
     Column::serialize(ser);
+    size_t bytes = plain_bytes_();
+    ser.write(bytes);
+    if (!edited_) {
+      ser.write(chars_.data(), bytes);
+      return;
+    }
+    ser.reserve(bytes);
     for (size_t i = 0; i < size(); i++)
       if (!is_missing(i))
-        ser.write(get(i));
+        ser.write(chars_at(i), length_at(i) + 1);
   }
 
-  /** Deserializes a StringColumn from the given deserializer object. **/
+  /** Deserializes a StringColumn from the given deserializer object. The
+   * block of characters becomes the column's arena. **/
   static StringColumn *deserialize(Deserializer &dser) {
     StringColumn *sc = new StringColumn();
     size_t len = dser.read_size_t();
-    BoolArray missing;
+    sc->missing_.deserialize(dser);
+    size_t bytes = dser.read_size_t();
+    sc->chars_.adopt(dser.read_chars(bytes), bytes);
+    size_t at = 0;
     for (size_t i = 0; i < len; i++) {
-      missing.push_back(dser.read_bool());
+      if (!sc->missing_.get(i))
+        at += strlen(sc->chars_.data() + at) + 1;
+      sc->adopted_.push_back(false);
+      sc->offsets_.push_back(at);
     }
-    for (size_t i = 0; i < len; i++) {
-      if (missing.get(i)) {
-        sc->push_back_missing();
+    return sc;
+  }
+};
+
+/*************************************************************************
+ * DictStringColumn::
+ * A StringColumn that keeps every distinct string once in a dictionary and
+ * stores an integer code per row. Rows are equal exactly when their codes
+ * are, so comparisons and grouping can work on the codes. The column owns
+ * its dictionary; get() returns strings owned by the dictionary.
+ *
+ * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu
+ */
+class DictStringColumn : public StringColumn {
+public:
+  StringArray dict_;       // owned; every distinct string, in code order
+  IntArray codes_;         // the code of each row, 0 in missing rows
+  SIMap *index_ = nullptr; // owned; string -> code, built when first needed
+
+  ~DictStringColumn() {
+    for (size_t i = 0; i < dict_.size(); i++) {
+      delete dict_.get(i);
+    }
+    delete index_;
+  }
+
+  /** Dictionary encodes the given column, giving up (and returning nullptr)
+   * once it has more than max_cardinality distinct strings, or once its
+   * dictionary and codes would take more than max_bytes to send. **/
+  static DictStringColumn *encode(StringColumn *from, size_t max_cardinality,
+                                  size_t max_bytes = (size_t)-1) {
+    DictStringColumn *dc = new DictStringColumn();
+    size_t dict_bytes = 0;
+    String view;
+    for (size_t i = 0; i < from->size(); i++) {
+      size_t before = dc->cardinality();
+      if (from->is_missing(i)) {
+        dc->push_back_missing();
       } else {
-        sc->push_back_steal_(String::deserialize(dser));
+        view.view(from->chars_at(i), from->length_at(i));
+        dc->push_back(&view);
+      }
+      if (dc->cardinality() > before)
+        dict_bytes += dc->dict_.get(before)->size() + 1;
+      if (dc->cardinality() > max_cardinality ||
+          dict_bytes + from->size() > max_bytes) {
+        delete dc;
+        return nullptr;
       }
     }
-    return sc;
+    return dc;
+  }
+
+  /** The number of distinct strings in the column. **/
+  size_t cardinality() { return dict_.size(); }
+
+  /** The code of the string at idx. Missing rows have code 0. **/
+  int code(size_t idx) { return codes_.get(idx); }
+
+  /** The string with the given code (owned by the column). **/
+  String *decode(int code) { return dict_.get(code); }
+
+  String *get(size_t idx) {
+    return is_missing(idx) ? nullptr : dict_.get(codes_.get(idx));
+  }
+
+  char *chars_at(size_t idx) { return dict_.get(codes_.get(idx))->c_str(); }
+
+  size_t length_at(size_t idx) { return dict_.get(codes_.get(idx))->size(); }
+
+  /** Acquire ownership of the string. Out of bound idx is undefined. **/
+  void set(size_t idx, String *val) {
+    missing_.set(idx, val == nullptr);
+    codes_.set(idx, (val == nullptr) ? 0 : intern_(val, true));
+  }
+
+  size_t size() { return codes_.size(); }
+
+  /** Strings are external, only new ones are cloned into the dictionary. **/
+  void push_back(String *s) {
+    if (s == nullptr) {
+      push_back_missing();
+    } else {
+      missing_.push_back(false);
+      codes_.push_back(intern_(s, false));
+    }
+  }
+
+  void push_back_steal_(String *s) {
+    missing_.push_back(false);
+    codes_.push_back(intern_(s, true));
+  }
+
+  void push_back_missing() {
+    Column::push_back_missing();
+    codes_.push_back(0);
+  }
+
+  /** Gets the code of a string, adding it to the dictionary if it is new.
+   * A stolen string is either kept by the dictionary or deleted. **/
+  int intern_(String *s, bool steal) {
+    if (index_ == nullptr) {
+      index_ = new SIMap();
+      for (size_t i = 0; i < dict_.size(); i++) {
+        index_->put(dict_.get(i), i);
+      }
+    }
+    if (index_->contains_key(s)) {
+      if (steal)
+        delete s;
+      return index_->get(s);
+    }
+    int code = dict_.size();
+    dict_.push_back(steal ? s : s->clone());
+    index_->put(s, code);
+    return code;
+  }
+
+  DictStringColumn *clone() {
+    DictStringColumn *dc = new DictStringColumn();
+    for (size_t i = 0; i < dict_.size(); i++) {
+      dc->dict_.push_back(dict_.get(i)->clone());
+    }
+    dc->codes_.concat(&codes_);
+    for (size_t i = 0; i < size(); i++) {
+      dc->missing_.push_back(is_missing(i));
+    }
+    return dc;
+  }
+
+  /** Columns sharing a dictionary are compared by their codes. **/
+  bool equals(Object *o) {
+    DictStringColumn *that = dynamic_cast<DictStringColumn *>(o);
+    if (that != nullptr && dict_.equals(&that->dict_))
+      return missing_.equals(&that->missing_) && codes_.equals(&that->codes_);
+    return StringColumn::equals(o);
+  }
+
+  /** Serializes the dictionary once, followed by the codes in one block.
+   * Codes take one or two bytes when the dictionary is small enough. **/
+  void serialize(Serializer &ser) {
+    ser.write('D');
+    ser.write(size());
+    missing_.serialize(ser);
+    ser.write(dict_.size());
+    for (size_t i = 0; i < dict_.size(); i++) {
+      ser.write(dict_.get(i));
+    }
+    char width = code_width_(dict_.size());
+    ser.write(width);
+    if (width == sizeof(int)) {
+      codes_.serialize_raw(ser);
+      return;
+    }
+    char *packed = new char[size() * width];
+    for (size_t i = 0; i < size(); i++) {
+      int code = codes_.get(i);
+      memcpy(packed + i * width, &code, width); // little endian
+    }
+    ser.write(packed, size() * width);
+    delete[] packed;
+  }
+
+  /** The number of bytes needed to send a code into a dictionary. **/
+  static char code_width_(size_t cardinality) {
+    if (cardinality <= 1 << 8)
+      return 1;
+    if (cardinality <= 1 << 16)
+      return 2;
+    return sizeof(int);
+  }
+
+  /** Deserializes a DictStringColumn from the given deserializer object. **/
+  static DictStringColumn *deserialize(Deserializer &dser) {
+    DictStringColumn *dc = new DictStringColumn();
+    size_t len = dser.read_size_t();
+    dc->missing_.deserialize(dser);
+    size_t num_strings = dser.read_size_t();
+    for (size_t i = 0; i < num_strings; i++) {
+      dc->dict_.push_back(String::deserialize(dser));
+    }
+    char width = dser.read_char();
+    if (width == sizeof(int)) {
+      dc->codes_.deserialize_raw(dser, len);
+      return dc;
+    }
+    char *packed = dser.read_chars(len * width);
+    for (size_t i = 0; i < len; i++) {
+      int code = 0;
+      memcpy(&code, packed + i * width, width);
+      dc->codes_.push_back(code);
+    }
+    delete[] packed;
+    return dc;
   }
 };
 
+/** Columns shorter than this are never worth dictionary encoding. **/
+static const size_t DICT_MIN_ROWS = 64;
+
+/** Sends the column dictionary encoded when at most half of its rows are
+ * distinct and the dictionary and codes are smaller than the characters,
+ * since that is when the dictionary pays for itself. A sample of the rows
+ * rules out columns of mostly distinct strings before anything is encoded. **/
+void StringColumn::serialize(Serializer &ser) {
+  DictStringColumn *dc = nullptr;
+  if (size() >= DICT_MIN_ROWS && mostly_repeated_())
+    dc = DictStringColumn::encode(this, size() / 2, plain_bytes_());
+  if (dc == nullptr) {
+    serialize_plain_(ser);
+  } else {
+    dc->serialize(ser);
+    delete dc;
+  }
+}
+
 /** Deserializes a column of the correct type. **/
 Column *Column::deserialize(Deserializer &dser) {
   switch (dser.read_char()) {
@@ -466,6 +811,8 @@ Column *Column::deserialize(Deserializer &dser) {
     return FloatColumn::deserialize(dser);
   case 'S':
     return StringColumn::deserialize(dser);
+  case 'D':
+    return DictStringColumn::deserialize(dser);
   default:
     assert(false);
     return nullptr;
@@ -1,41 +1,57 @@
 // lang: CwC
 #pragma once
 
-#include "../utils/thread.h"
+#include "../utils/pool.h"
 #include "kvstore-fd.h"
 #include "parser.h"
+#include "predicate.h"
 #include "rows.h"
 
-/** Static variable for number of rows before we consider multi-threading. **/
-/** This will also be used as a number of when to determine the amount of
- * threads. **/
-static const size_t MIN_NROWS_PER_THREAD = 500000;
+/*******************************************************************************
+ * PmapTask::
+ *
+ * A PmapTask applies a Rower to a DataFrame a chunk of Rows at a time, with a
+ * clone of the Rower for each slot of the pool that runs it.
+ *
+ * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu
+ */
+class PmapTask : public ParallelTask {
+public:
+  DataFrame *df_;
+  Rower **rowers_; // external; one per slot
+  Bitset columns_; // every column
 
-/** This makes sure we don't go overboard with our number of threads. **/
-static const size_t MAX_NUM_THREADS = 8;
+  /** Initializes a PmapTask. Nullptr DataFrame and Rowers are undefined
+   * behavior. **/
+  PmapTask(DataFrame *df, Rower **rowers);
+
+  void run(size_t m, size_t slot);
+};
 
 /*******************************************************************************
- * RowThread::
+ * LocalPmapTask::
  *
- * A RowThread asynchronously applies a given Rower to a range of Rows in a
- * DataFrame.
+ * A LocalPmapTask applies a Rower to the chunks of a distributed DataFrame
+ * that are stored on this node, a chunk per morsel. Each slot of the pool
+ * loads its chunks into its own buffer DataFrame and runs its own clone of
+ * the Rower.
  *
  * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu
  */
-class RowThread : public Thread {
+class LocalPmapTask : public ParallelTask {
 public:
   DataFrame *df_;
-  Rower *rower_;
-  size_t start_, end_;
+  SizeTArray *chunks_;  // external; the chunks stored here
+  Bitset *columns_;     // external; the columns to load
+  Rower **rowers_;      // external; one per slot
+  DataFrame **buffers_; // external; one per slot
 
-  /** Initializes a RowThread. Nullptr DataFrame and Rowers are undefined
-   * behavior. **/
-  RowThread(DataFrame *df, Rower *rower, size_t start, size_t end)
-      : df_(df), rower_(rower), start_(start), end_(end) {
-    assert(start < end);
-  }
+  LocalPmapTask(DataFrame *df, SizeTArray *chunks, Bitset *columns,
+                Rower **rowers, DataFrame **buffers)
+      : df_(df), chunks_(chunks), columns_(columns), rowers_(rowers),
+        buffers_(buffers) {}
 
-  void run();
+  void run(size_t m, size_t slot);
 };
 
 /****************************************************************************
@@ -146,33 +162,39 @@ public:
 
   /** Set the fields of the given row object with values from the columns
    * at the given offset.  If the row is not form the same schema as the
-   * dataframe, results are undefined.
+   * dataframe, results are undefined. String fields are views of the
+   * dataframe's characters, valid until a row is added to it.
    */
   void fill_row(size_t idx, Row &row) {
     row.set_idx(idx);
-
     for (size_t i = 0; i < ncols(); i++) {
-      if (is_missing(i, idx)) {
-        row.set_missing(i);
-        continue;
-      }
-      switch (scm_->col_type(i)) {
-      case 'B':
-        row.set(i, local_get_bool(i, idx));
-        break;
-      case 'I':
-        row.set(i, local_get_int(i, idx));
-        break;
-      case 'F':
-        row.set(i, local_get_float(i, idx));
-        break;
-      case 'S':
-        row.set(i, local_get_string(i, idx)->clone());
-        break;
-      default:
-        assert(false);
-        break;
-      }
+      fill_field_(i, idx, row);
+    }
+  }
+
+  /** Sets one field of the row from the value in column col at idx. **/
+  void fill_field_(size_t col, size_t idx, Row &row) {
+    if (is_missing(col, idx)) {
+      row.set_missing(col);
+      return;
+    }
+    switch (scm_->col_type(col)) {
+    case 'B':
+      row.set(col, local_get_bool(col, idx));
+      break;
+    case 'I':
+      row.set(col, local_get_int(col, idx));
+      break;
+    case 'F':
+      row.set(col, local_get_float(col, idx));
+      break;
+    case 'S':
+      row.view(col, cols_.get(col)->as_string()->chars_at(idx),
+               cols_.get(col)->as_string()->length_at(idx));
+      break;
+    default:
+      assert(false);
+      break;
     }
   }
 
@@ -216,13 +238,14 @@ public:
     return is_distributed_ ? dist_scm_->width() : scm_->width();
   }
 
-  /** Visit rows in order */
+  /** Visit rows in order, a batch of up to CHUNK_SIZE rows at a time */
   void map(Rower &r) {
     assert(!is_distributed_);
-    Row row(*scm_);
-    for (size_t i = 0; i < nrows(); i++) {
-      fill_row(i, row);
-      r.accept(row);
+    Bitset all(ncols(), true);
+    for (size_t start = 0; start < nrows(); start += CHUNK_SIZE) {
+      size_t n = Util::min(CHUNK_SIZE, nrows() - start);
+      Batch batch(*scm_, cols_, all, start, start, n);
+      r.accept_batch(batch);
     }
   }
 
@@ -246,51 +269,35 @@ public:
     map(pr);
   }
 
-  /** This method clones the Rower and executes the map in parallel. Join is
-   * used at the end to merge the results. */
+  /** This method clones the Rower and executes the map in parallel on the
+   * process's thread pool, a chunk of rows per task. Join is used at the end
+   * to merge the results. Chunks are stolen between the clones, so each one
+   * sees an arbitrary set of chunks and the rower's join_delete must not
+   * depend on order. A rower that cannot be cloned is run with map. */
   void pmap(Rower &r) {
     assert(!is_distributed_);
-    // Default to one thread.
-    size_t num_threads = 1;
-    size_t rows_per_thread = (nrows() / num_threads) + 1;
-
-    // While our rows per thread is greater than double our minimum
-    while (rows_per_thread >= MIN_NROWS_PER_THREAD * 2 &&
-           num_threads < MAX_NUM_THREADS) {
-      num_threads++;
-      rows_per_thread = (nrows() / num_threads) + 1;
-    }
+    size_t nchunks = (nrows() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    ThreadPool &pool = ThreadPool::instance();
 
     // If we aren't big enough to warrant multiple threads, defer to map.
-    if (num_threads == 1) {
+    if (nchunks <= 1 || pool.slots() == 1) {
       return map(r);
     }
-
-    RowThread **row_threads = new RowThread *[num_threads];
-    Rower **rowers = new Rower *[num_threads];
-
-    // Spawn Threads (inefficient, but will do for now)
-    for (size_t i = 0; i < num_threads; i++) {
-      // Select start and end as a maximum of chunk sizes
-      size_t start = rows_per_thread * i;
-      size_t chunk_end = (i + 1) * rows_per_thread;
-      size_t end = (nrows() <= chunk_end) ? nrows() : chunk_end;
-
-      // Clone the given rower and start all of the threads
-      rowers[i] = (i == 0) ? &r : rowers[i - 1]->clone();
-      row_threads[i] = new RowThread(this, rowers[i], start, end);
-      row_threads[i]->start();
+    Rower *first = r.clone();
+    if (first == nullptr) {
+      return map(r);
     }
 
-    // Assure all threads are finished
-    for (size_t i = 0; i < num_threads; i++) {
-      row_threads[i]->join();
-      delete row_threads[i];
+    size_t nslots = pool.slots();
+    Rower **rowers = new Rower *[nslots];
+    for (size_t i = 0; i < nslots; i++) {
+      rowers[i] = (i == 0) ? &r : (i == 1) ? first : r.clone();
     }
-    delete[] row_threads;
+    PmapTask task(this, rowers);
+    pool.parallel_for(task, nchunks);
 
     // Join delete the rowers to reduce the result.
-    for (size_t i = num_threads - 1; i > 0; i--) {
+    for (size_t i = nslots - 1; i > 0; i--) {
       rowers[i - 1]->join_delete(rowers[i]);
     }
     delete[] rowers;
@@ -355,121 +362,362 @@ public:
     }
     must_load_ = false;
 
-    // Set up key parameters
-    StrBuff sb;
-    sb.c(*key_->key()).c("-column").c(col).c("-chunk").c(desired_chunk);
-    size_t target = (key_->node() + desired_chunk) % arg.num_nodes;
-
     // Determine if we should grab this data from another node.
-    Key *chunk_key = new Key(sb.get(), target);
+    size_t target = (key_->node() + desired_chunk) % arg.num_nodes;
+    Key *chunk_key = new ChunkKey(*key_, col, desired_chunk, target);
     Value *val = (target == store_->index())
                      ? store_->get_value(chunk_key)->clone()
-                     : store_->get_and_wait_value(chunk_key);
-    Deserializer dser(val->steal());
+                     : fetch_(chunk_key);
+    Deserializer dser(*val->blob());
+    delete cols_.set(col, Column::deserialize(dser));
     delete chunk_key;
     delete val;
-    delete cols_.set(col, Column::deserialize(dser));
     dist_scm_->chunk_indexes_->set(col, desired_chunk);
     return true;
   }
 
+  /** Gets the value of a chunk stored on another node, which the caller
+   * owns, going to the network only if this node has not cached it. **/
+  Value *fetch_(Key *chunk_key) {
+    Value *val = store_->cache()->get(chunk_key);
+    if (val == nullptr) {
+      val = store_->get_and_wait_value(chunk_key);
+      store_->cache()->put(chunk_key, val);
+    }
+    return val;
+  }
+
+  /** Requests the given columns of a remote chunk that are not cached without
+   * waiting for them. Returns nullptr if there is nothing to request. **/
+  PendingChunk *prefetch_(size_t chunk, Bitset &columns) {
+    if (is_locally_stored_(chunk))
+      return nullptr;
+    size_t target = ((chunk + key_->node()) % arg.num_nodes);
+    KeyArray *keys = new KeyArray();
+    for (size_t col = 0; col < dist_scm_->width(); col++) {
+      if (!columns.get(col))
+        continue;
+      Key *chunk_key = new ChunkKey(*key_, col, chunk, target);
+      if (store_->cache()->contains(chunk_key))
+        delete chunk_key;
+      else
+        keys->push_back(chunk_key);
+    }
+    if (keys->size() == 0) {
+      delete keys;
+      return nullptr;
+    }
+    return new PendingChunk(chunk, keys, store_->get_many_async(keys));
+  }
+
   /** Determines if the chunk is locally stored on this node. **/
   bool is_locally_stored_(size_t chunk) {
     return ((chunk + key_->node()) % arg.num_nodes) == store_->index();
   }
 
-  /** Loads data from a chunk into this dataframe. **/
-  void load_(size_t chunk) {
+  /** Loads the given columns of a chunk into this dataframe. The other
+   * columns keep whichever chunk they last loaded. Columns that were
+   * prefetched are taken from arrived, if given. **/
+  void load_(size_t chunk, Bitset &columns, PendingChunk *arrived = nullptr) {
     assert(is_distributed_);
     if (is_locally_stored_(chunk)) {
-      local_load_(chunk);
+      local_load_(chunk, columns);
     } else {
-      nonlocal_load_(chunk);
+      nonlocal_load_(chunk, columns, arrived);
     }
   }
 
   /** Locally loads data from this keyvalue store. **/
-  void local_load_(size_t chunk) {
+  void local_load_(size_t chunk, Bitset &columns) {
     assert(is_distributed_ && is_locally_stored_(chunk));
     for (size_t col = 0; col < dist_scm_->width(); col++) {
-      StrBuff sb;
-      sb.c(*key_->key()).c("-column").c(col).c("-chunk").c(chunk);
-      Key *chunk_key = new Key(sb.get(), store_->index());
-
-      Value *val = store_->get_value(chunk_key);
-      Deserializer dser(*val->blob());
-      delete cols_.set(col, Column::deserialize(dser));
-
-      delete chunk_key;
+      if (!columns.get(col))
+        continue;
+      delete cols_.set(col, local_column_(col, chunk));
       dist_scm_->chunk_indexes_->set(col, chunk);
     }
   }
 
-  /** Non-locally loads data from the desired key value store. **/
-  void nonlocal_load_(size_t chunk) {
+  /** Deserializes a column of a chunk stored on this node. The caller owns
+   * the column. Safe to call from many threads. **/
+  Column *local_column_(size_t col, size_t chunk) {
+    assert(is_distributed_);
+    ChunkKey chunk_key(*key_, col, chunk, store_->index());
+    Value *val = store_->get_value(&chunk_key);
+    Deserializer dser(*val->blob());
+    return Column::deserialize(dser);
+  }
+
+  /** Non-locally loads data from the desired key value store. Columns are
+   * taken from the prefetched chunk if there is one, then from the cache,
+   * and the rest are requested in a single round trip. **/
+  void nonlocal_load_(size_t chunk, Bitset &columns,
+                      PendingChunk *arrived = nullptr) {
     assert(is_distributed_ && !is_locally_stored_(chunk));
     size_t target = ((chunk + key_->node()) % arg.num_nodes);
 
+    KeyArray keys, missing;
+    ValueArray values;
     for (size_t col = 0; col < dist_scm_->width(); col++) {
-      StrBuff sb;
-      sb.c(*key_->key()).c("-column").c(col).c("-chunk").c(chunk);
-      Key *chunk_key = new Key(sb.get(), target);
+      if (!columns.get(col)) {
+        keys.push_back(nullptr);
+        values.push_back(nullptr);
+        continue;
+      }
+      Key *chunk_key = new ChunkKey(*key_, col, chunk, target);
+      Value *val = (arrived == nullptr) ? nullptr : arrived->take(chunk_key);
+      if (val != nullptr)
+        store_->cache()->put(chunk_key, val);
+      else
+        val = store_->cache()->get(chunk_key);
+      keys.push_back(chunk_key);
+      values.push_back(val);
+      if (val == nullptr)
+        missing.push_back(chunk_key);
+    }
 
-      Value *val = store_->get_and_wait_value(chunk_key);
-      Deserializer dser(val->steal());
+    if (missing.size() > 0) {
+      Future *request = store_->get_many_async(&missing);
+      MultiReply *reply = dynamic_cast<MultiReply *>(request->reply());
+      for (size_t col = 0, i = 0; col < dist_scm_->width(); col++) {
+        if (!columns.get(col) || values.get(col) != nullptr)
+          continue;
+        Value *val = reply->steal_value(i++);
+        store_->cache()->put(keys.get(col), val);
+        values.set(col, val);
+      }
+      delete request;
+    }
+
+    for (size_t col = 0; col < dist_scm_->width(); col++) {
+      if (!columns.get(col))
+        continue;
+      Deserializer dser(*values.get(col)->blob());
       delete cols_.set(col, Column::deserialize(dser));
-      delete val;
-      delete chunk_key;
+      delete keys.get(col);
+      delete values.get(col);
       dist_scm_->chunk_indexes_->set(col, chunk);
     }
   }
 
   /** Performs a map operation on only the local data **/
   void local_map(Rower &rower) {
+    Bitset all(dist_scm_->width(), true);
+    local_map(rower, all);
+  }
+
+  /** Performs a map operation on only the local data, loading only the
+   * columns set in the projection. The other fields of each row are
+   * missing. **/
+  void local_map(Rower &rower, Bitset &columns) {
     assert(is_distributed_);
 
     size_t MAX_ROWS = dist_scm_->length();
     size_t NUM_CHUNKS = MAX_ROWS / CHUNK_SIZE;
     size_t MAX_CHUNKS =
         (MAX_ROWS % CHUNK_SIZE == 0) ? NUM_CHUNKS : NUM_CHUNKS + 1;
-    Row row(get_schema());
     for (size_t cur_chunk = 0; cur_chunk < MAX_CHUNKS; cur_chunk++) {
       // Check to see if the chunk is stored locally
       if (!is_locally_stored_(cur_chunk))
         continue;
-      load_(cur_chunk);
-
-      size_t end_of_chunk = (cur_chunk + 1) * CHUNK_SIZE;
-      size_t limit = Util::min(end_of_chunk, dist_scm_->length());
-      for (size_t idx = cur_chunk * CHUNK_SIZE; idx < limit; idx++) {
-        fill_row(idx % CHUNK_SIZE, row);
-        row.set_idx(idx);
-        rower.accept(row);
-      }
+      load_(cur_chunk, columns);
+      visit_chunk_(cur_chunk, rower, columns);
+    }
+  }
+
+  /** Performs a map operation on only the local data, in parallel. **/
+  void local_pmap(Rower &rower) {
+    Bitset all(dist_scm_->width(), true);
+    local_pmap(rower, all);
+  }
+
+  /** Performs a map operation on only the local data, loading only the
+   * columns set in the projection, with the chunks spread over the
+   * process's thread pool. Each slot loads chunks into its own buffers and
+   * runs its own clone of the rower; the clones are joined into the rower
+   * at the end, so as with pmap the join must not depend on order. A rower
+   * that cannot be cloned is run with local_map. **/
+  void local_pmap(Rower &rower, Bitset &columns) {
+    assert(is_distributed_);
+    size_t nchunks = (dist_scm_->length() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    SizeTArray owned;
+    for (size_t chunk = 0; chunk < nchunks; chunk++) {
+      if (is_locally_stored_(chunk))
+        owned.push_back(chunk);
+    }
+    ThreadPool &pool = ThreadPool::instance();
+
+    // A single chunk or a single core gains nothing from the pool.
+    if (owned.size() <= 1 || pool.slots() == 1) {
+      return local_map(rower, columns);
+    }
+    Rower *first = rower.clone();
+    if (first == nullptr) {
+      return local_map(rower, columns);
+    }
+
+    size_t nslots = pool.slots();
+    Rower **rowers = new Rower *[nslots];
+    DataFrame **buffers = new DataFrame *[nslots];
+    for (size_t i = 0; i < nslots; i++) {
+      rowers[i] = (i == 0) ? &rower : (i == 1) ? first : rower.clone();
+      buffers[i] = new DataFrame(get_schema());
+    }
+    LocalPmapTask task(this, &owned, &columns, rowers, buffers);
+    pool.parallel_for(task, owned.size());
+
+    // Join delete the rowers to reduce the result.
+    for (size_t i = nslots - 1; i > 0; i--) {
+      rowers[i - 1]->join_delete(rowers[i]);
+    }
+    for (size_t i = 0; i < nslots; i++) {
+      delete buffers[i];
+    }
+    delete[] rowers;
+    delete[] buffers;
+  }
+
+  /** Runs the rower over every chunk at the node that stores it, instead of
+   * pulling the chunks here. Every other node runs a fresh copy of the
+   * rower, while this node maps the rower itself over its own chunks; the
+   * states the copies end with are joined into the rower with join_delete,
+   * so whatever the rower held before is counted once. **/
+  void owner_map(RemoteRower &rower) {
+    assert(is_distributed_);
+    FutureArray requests;
+    for (size_t node = 0; node < arg.num_nodes; node++) {
+      if (node != store_->index())
+        requests.push_back(store_->execute_async(node, key_, &rower));
+    }
+
+    local_map(rower);
+
+    String name(rower.name());
+    for (size_t i = 0; i < requests.size(); i++) {
+      Future *request = requests.get(i);
+      RemoteRower *remote = store_->registry()->create(&name);
+      Deserializer dser(*request->value()->blob());
+      remote->restore(dser);
+      rower.join_delete(remote);
+      delete request;
     }
   }
 
   /** Performs a map operation on the entire distributed dataframe. **/
   void distributed_map(Rower &rower) {
+    Bitset all(dist_scm_->width(), true);
+    distributed_map(rower, all);
+  }
+
+  /** Performs a map operation on the entire distributed dataframe, loading
+   * only the columns set in the projection. The other fields of each row
+   * are missing. **/
+  void distributed_map(Rower &rower, Bitset &columns) {
     assert(is_distributed_);
 
     size_t MAX_ROWS = dist_scm_->length();
     size_t NUM_CHUNKS = MAX_ROWS / CHUNK_SIZE;
     size_t MAX_CHUNKS =
         (MAX_ROWS % CHUNK_SIZE == 0) ? NUM_CHUNKS : NUM_CHUNKS + 1;
-    Row row(get_schema());
+    // Remote chunks are requested up to arg.prefetch chunks ahead of the one
+    // being visited, so the network works while the rower does.
+    PendingChunkArray pending;
+    size_t next_prefetch = 0;
     for (size_t cur_chunk = 0; cur_chunk < MAX_CHUNKS; cur_chunk++) {
-      load_(cur_chunk);
+      for (; next_prefetch < MAX_CHUNKS &&
+             next_prefetch <= cur_chunk + arg.prefetch;
+           next_prefetch++) {
+        PendingChunk *ahead = prefetch_(next_prefetch, columns);
+        if (ahead != nullptr)
+          pending.push_back(ahead);
+      }
+      PendingChunk *arrived = nullptr;
+      if (pending.size() > 0 && pending.get(0)->chunk_ == cur_chunk)
+        arrived = pending.remove(0);
+      load_(cur_chunk, columns, arrived);
+      delete arrived;
+      visit_chunk_(cur_chunk, rower, columns);
+    }
+  }
 
-      size_t end_of_chunk = (cur_chunk + 1) * CHUNK_SIZE;
-      size_t limit = Util::min(end_of_chunk, dist_scm_->length());
+  /** Hands the loaded chunk to the rower as a single batch. **/
+  void visit_chunk_(size_t chunk, Rower &rower, Bitset &columns) {
+    size_t start = chunk * CHUNK_SIZE;
+    size_t n = Util::min(CHUNK_SIZE, dist_scm_->length() - start);
+    Batch batch(get_schema(), cols_, columns, start, 0, n);
+    rower.accept_batch(batch);
+  }
 
-      for (size_t idx = cur_chunk * CHUNK_SIZE; idx < limit; idx++) {
-        fill_row(idx % CHUNK_SIZE, row);
-        row.set_idx(idx);
-        rower.accept(row);
+  /** Evaluates the predicate at the node that stores each chunk, which only
+   * sends back the rows that satisfy it. Every chunk is requested before any
+   * answer is waited on. Returns a new local dataframe of those rows, in
+   * order. **/
+  DataFrame *distributed_filter(Predicate &pred) {
+    assert(is_distributed_);
+    size_t MAX_ROWS = dist_scm_->length();
+    size_t NUM_CHUNKS = MAX_ROWS / CHUNK_SIZE;
+    size_t MAX_CHUNKS =
+        (MAX_ROWS % CHUNK_SIZE == 0) ? NUM_CHUNKS : NUM_CHUNKS + 1;
+
+    FutureArray requests;
+    for (size_t chunk = 0; chunk < MAX_CHUNKS; chunk++) {
+      size_t target = ((chunk + key_->node()) % arg.num_nodes);
+      KeyArray keys;
+      for (size_t col = 0; col < dist_scm_->width(); col++) {
+        keys.push_back(new ChunkKey(*key_, col, chunk, target));
+      }
+      requests.push_back(store_->filter_async(&keys, &pred));
+      for (size_t col = 0; col < keys.size(); col++) {
+        delete keys.get(col);
       }
     }
+
+    DataFrame *df = new DataFrame(get_schema());
+    Row row(get_schema());
+    for (size_t chunk = 0; chunk < MAX_CHUNKS; chunk++) {
+      Future *request = requests.get(chunk);
+      MultiReply *reply = dynamic_cast<MultiReply *>(request->reply());
+      Schema empty;
+      DataFrame kept(empty);
+      for (size_t col = 0; col < reply->values()->size(); col++) {
+        Deserializer dser(*reply->values()->get(col)->blob());
+        Column *column = Column::deserialize(dser);
+        kept.add_column(column);
+        delete column;
+      }
+      for (size_t i = 0; i < kept.nrows(); i++) {
+        kept.fill_row(i, row);
+        df->add_row(row);
+      }
+      delete request;
+    }
+    return df;
+  }
+
+  /** Keeps the rows of a chunk that satisfy the predicate. The chunk is given
+   * as one serialized column per value, which are external. Returns the kept
+   * rows in the same form; the array and its values are owned by the
+   * caller. **/
+  static ValueArray *filter_chunk(ValueArray *columns, Predicate &pred) {
+    Schema empty;
+    DataFrame chunk(empty);
+    for (size_t col = 0; col < columns->size(); col++) {
+      Deserializer dser(*columns->get(col)->blob());
+      Column *column = Column::deserialize(dser);
+      chunk.add_column(column);
+      delete column;
+    }
+
+    PredicateRower keep(pred);
+    DataFrame *kept = chunk.filter(keep);
+    ValueArray *filtered = new ValueArray();
+    for (size_t col = 0; col < kept->ncols(); col++) {
+      Serializer ser;
+      ser.write(kept->cols_.get(col));
+      filtered->push_back(new Value(ser.steal()));
+    }
+    delete kept;
+    return filtered;
   }
 
   /** Normalizes a row index to the current chunk offset for that column. **/
@@ -513,12 +761,10 @@ public:
       // Serialize and store this chunk of the column.
       Serializer ser;
       fc.serialize(ser);
-      Value *value = new Value(*ser.data());
-
-      StrBuff sb;
-      sb.c(*key->key()).c("-column0-chunk").c(c);
+      Value *value = new Value(ser.steal());
 
-      Key *chunk_key = new Key(sb.get(), (key->node() + c) % arg.num_nodes);
+      size_t target = (key->node() + c) % arg.num_nodes;
+      Key *chunk_key = new ChunkKey(*key, 0, c, target);
       kv->put(chunk_key, value);
       delete chunk_key;
     }
@@ -545,12 +791,10 @@ public:
     df->set_distributed_schema_(key, distributed_schema);
 
     // Add the chunk with one value.
-    StrBuff sb;
-    sb.c(*key->key()).c("-column0-chunk0");
     Serializer fc_ser;
     fc.serialize(fc_ser);
 
-    Key *chunk_key = new Key(sb.get(), key->node());
+    Key *chunk_key = new ChunkKey(*key, 0, 0, key->node());
     kv->put(chunk_key, new Value(fc_ser.steal()));
     delete chunk_key;
 
@@ -575,12 +819,10 @@ public:
     df->set_distributed_schema_(key, distributed_schema);
 
     // Add the chunk with one value.
-    StrBuff sb;
-    sb.c(*key->key()).c("-column0-chunk0");
     Serializer ic_ser;
     ic.serialize(ic_ser);
 
-    Key *chunk_key = new Key(sb.get(), key->node());
+    Key *chunk_key = new ChunkKey(*key, 0, 0, key->node());
     kv->put(chunk_key, new Value(ic_ser.steal()));
     delete chunk_key;
 
@@ -658,32 +900,52 @@ public:
   /** Distributes an array of columns at the specified chunk **/
   static void distribute_columns(ColumnArray *ca, size_t chunk, Key *k,
                                  KVStore *kv) {
+    // Every column of a chunk lives on the same node, so send them together
+    size_t target = ((k->node() + chunk) % arg.num_nodes);
+    KeyArray keys;
+    ValueArray values;
     for (size_t col = 0; col < ca->size(); col++) {
       // Build the key for the current column chunk
-      size_t target = ((k->node() + chunk) % arg.num_nodes);
-      StrBuff sb;
-      sb.c(*k->key()).c("-column").c(col).c("-chunk").c(chunk);
-      Key *chunk_key = new Key(sb.get(), target);
+      keys.push_back(new ChunkKey(*k, col, chunk, target));
 
       // Serialize the column into a value
       Serializer ser;
       ser.write(ca->get(col));
-      kv->put(chunk_key, new Value(ser.steal()));
-      delete chunk_key;
+      values.push_back(new Value(ser.steal()));
 
       // Reinitialize the column
       char type = ca->get(col)->get_type();
       delete ca->set(col, Column::init(type));
     }
+    kv->put_many(&keys, &values);
+    for (size_t col = 0; col < keys.size(); col++) {
+      delete keys.get(col);
+    }
   }
 };
 
-/** Applies this RowThread's rower on a range of Rows
- * of a DataFrame. **/
-void RowThread::run() {
-  Row row(df_->get_schema());
-  for (size_t i = start_; i < end_; i++) {
-    df_->fill_row(i, row);
-    rower_->accept(row);
-  }
+PmapTask::PmapTask(DataFrame *df, Rower **rowers)
+    : df_(df), rowers_(rowers), columns_(df->ncols(), true) {}
+
+/** Applies the slot's rower to the m-th chunk of Rows of the DataFrame. **/
+void PmapTask::run(size_t m, size_t slot) {
+  size_t start = m * CHUNK_SIZE;
+  size_t n = Util::min(CHUNK_SIZE, df_->nrows() - start);
+  Batch batch(df_->get_schema(), df_->cols_, columns_, start, start, n);
+  rowers_[slot]->accept_batch(batch);
+}
+
+/** Loads the m-th local chunk into the slot's buffer and applies the slot's
+ * rower to its Rows, numbered as in the whole DataFrame. **/
+void LocalPmapTask::run(size_t m, size_t slot) {
+  size_t chunk = chunks_->get(m);
+  DataFrame *buffer = buffers_[slot];
+  for (size_t col = 0; col < df_->ncols(); col++) {
+    if (columns_->get(col))
+      delete buffer->cols_.set(col, df_->local_column_(col, chunk));
+  }
+  size_t start = chunk * CHUNK_SIZE;
+  size_t n = Util::min(CHUNK_SIZE, df_->nrows() - start);
+  Batch batch(df_->get_schema(), buffer->cols_, *columns_, start, 0, n);
+  rowers_[slot]->accept_batch(batch);
 }
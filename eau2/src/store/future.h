@@ -0,0 +1,98 @@
+#pragma once
+// lang: CwC
+
+#include "../client/message.h"
+
+/** Forward declaration of Future. **/
+class Future;
+
+/** Something to run once a Future completes.
+ * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
+class Callback : public Object {
+public:
+  /** Called exactly once with the completed future. This runs on the thread
+   * that completed the future (usually a KVStore's servicer), so it should
+   * not block. The callback may delete the future. **/
+  virtual void complete(Future *f) {}
+};
+
+/** Represents the eventual answer to a request made to another node. A
+ * Future is completed by the message that answers it, which it then owns.
+ * Deleting a future before it has completed is undefined.
+ * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
+class Future : public Object {
+public:
+  Lock lock_;
+  bool done_ = false;
+  Message *reply_ = nullptr;     // owned; the answer to the request
+  Callback *callback_ = nullptr; // external
+
+  ~Future() { delete reply_; }
+
+  /** Polls whether or not the future has completed. **/
+  bool ready() {
+    lock_.lock();
+    bool hold = done_;
+    lock_.unlock();
+    return hold;
+  }
+
+  /** Blocks until the future has completed. **/
+  Future *wait() {
+    lock_.lock();
+    while (!done_) {
+      lock_.wait();
+    }
+    lock_.unlock();
+    return this;
+  }
+
+  /** Runs the given callback once the future completes. If it already has,
+   * the callback runs right away on the calling thread. **/
+  void then(Callback *cb) {
+    lock_.lock();
+    if (!done_) {
+      assert(callback_ == nullptr);
+      callback_ = cb;
+      lock_.unlock();
+      return;
+    }
+    lock_.unlock();
+    cb->complete(this);
+  }
+
+  /** Completes this future with the answering message, consuming it. **/
+  void complete(Message *reply) {
+    lock_.lock();
+    assert(!done_);
+    reply_ = reply;
+    done_ = true;
+    Callback *cb = callback_;
+    lock_.notify_all();
+    lock_.unlock();
+    if (cb != nullptr)
+      cb->complete(this);
+  }
+
+  /** Waits for and returns the answering message (owned by the future). **/
+  Message *reply() { return wait()->reply_; }
+
+  /** Waits for the value answering a get. The value is owned by the future,
+   * returns nullptr if the future was not answered by a value. **/
+  Value *value() {
+    Reply *r = dynamic_cast<Reply *>(reply());
+    return (r == nullptr) ? nullptr : r->value();
+  }
+
+  /** Waits for the value answering a get and takes ownership of it. **/
+  Value *steal_value() {
+    Reply *r = dynamic_cast<Reply *>(reply());
+    assert(r != nullptr);
+    Value *hold = r->value_;
+    r->value_ = nullptr;
+    return hold;
+  }
+};
+
+/** Here's an array of futures. **/
+generate_object_classarray(FutureArray, Future);
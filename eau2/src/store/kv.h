@@ -1,7 +1,12 @@
 #pragma once
 // lang: CwC
 
+#include "../utils/buffer.h"
 #include "../utils/map.h"
+#include <atomic>
+
+/** Forward declaration of ChunkKey. **/
+class ChunkKey;
 
 /** A Key that represents where data is stored. **/
 class Key : public Object {
@@ -21,7 +26,8 @@ public:
   /** Hash/Clone functions for storage in a map **/
   bool equals(Object *other) {
     Key *that = dynamic_cast<Key *>(other);
-    return (that != nullptr) && (this->key()->equals(that->key())) &&
+    return (that != nullptr) && (that->as_chunk() == nullptr) &&
+           (this->key()->equals(that->key())) &&
            (this->node() == that->node());
   }
   size_t hash() { return key_->hash(); }
@@ -29,40 +35,138 @@ public:
 
   /** Serializes a key **/
   void serialize(Serializer &ser) {
+    ser.write('K');
     ser.write(key_);
     ser.write(node_);
   }
 
-  /** Deserializes a key **/
-  static Key *deserialize(Deserializer &dser) {
-    String *k = String::deserialize(dser);
-    size_t n = dser.read_size_t();
-    return new Key(k, n);
-  }
+  /** Deserializes a key or a chunk key **/
+  static Key *deserialize(Deserializer &dser);
 
   /** Getters for a key **/
   String *key() { return key_; }
   size_t node() { return node_; }
+
+  /** Returns this key as a ChunkKey, or nullptr if it is not one. **/
+  virtual ChunkKey *as_chunk() { return nullptr; }
+};
+
+/** The key of one column of one chunk of a distributed DataFrame. Rather than
+ * formatting a name for every chunk, it keeps the DataFrame's key name with
+ * the column and chunk indices, so building, hashing and comparing one costs
+ * a few integer operations (the name's hash is cached).
+ * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
+class ChunkKey : public Key {
+public:
+  size_t column_;
+  size_t chunk_;
+
+  /** The key of the given column and chunk of the DataFrame stored at base,
+   * which lives on the given node. **/
+  ChunkKey(Key &base, size_t column, size_t chunk, size_t node)
+      : Key(base.key()->clone(), node), column_(column), chunk_(chunk) {}
+  ChunkKey(String *base, size_t column, size_t chunk, size_t node)
+      : Key(base, node), column_(column), chunk_(chunk) {}
+  ChunkKey(ChunkKey &k) : Key(k), column_(k.column_), chunk_(k.chunk_) {}
+
+  bool equals(Object *other) {
+    Key *key = dynamic_cast<Key *>(other);
+    ChunkKey *that = (key == nullptr) ? nullptr : key->as_chunk();
+    return (that != nullptr) && (that->chunk_ == chunk_) &&
+           (that->column_ == column_) && (that->node() == node()) &&
+           key_->equals(that->key_);
+  }
+
+  size_t hash() {
+    size_t hash = (key_->hash() ^ column_) * 0x9E3779B97F4A7C15ULL;
+    hash = (hash ^ chunk_) * 0x9E3779B97F4A7C15ULL;
+    return hash ^ (hash >> 32);
+  }
+
+  ChunkKey *clone() { return new ChunkKey(*this); }
+
+  /** Serializes a chunk key **/
+  void serialize(Serializer &ser) {
+    ser.write('C');
+    ser.write(key_);
+    ser.write(node_);
+    ser.write(column_);
+    ser.write(chunk_);
+  }
+
+  size_t column() { return column_; }
+  size_t chunk() { return chunk_; }
+  ChunkKey *as_chunk() { return this; }
 };
 
-/** A Value is a serialized blob of data. **/
+Key *Key::deserialize(Deserializer &dser) {
+  char kind = dser.read_char();
+  String *k = String::deserialize(dser);
+  size_t n = dser.read_size_t();
+  if (kind == 'K')
+    return new Key(k, n);
+  assert(kind == 'C');
+  size_t column = dser.read_size_t();
+  size_t chunk = dser.read_size_t();
+  return new ChunkKey(k, column, chunk, n);
+}
+
+/** An immutable, reference counted buffer of serialized bytes. Values that
+ * are clones of each other share one Blob instead of copying the bytes.
+ * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
+class Blob : public Object {
+public:
+  Buffer *data_;                // owned; never modified once shared
+  std::atomic<size_t> refs_{1}; // how many Values share this blob
+
+  Blob(Buffer *data) : data_(data) {}
+  ~Blob() { delete data_; }
+
+  /** Adds a reference to this blob. **/
+  Blob *retain() {
+    refs_++;
+    return this;
+  }
+
+  /** Drops a reference to this blob, deleting it with the last one. **/
+  void release() {
+    if (--refs_ == 0)
+      delete this;
+  }
+};
+
+/** A Value is a serialized blob of data. Values are immutable, so cloning
+ * one only shares its blob. **/
 class Value : public Object {
 public:
-  CharArray *blob_;
+  Blob *blob_; // shared
 
   /** Values are initialized with all of the data. **/
-  Value(CharArray *blob) : blob_(blob) {}
-  Value(CharArray &blob) : blob_(blob.clone()) {}
-  Value(Deserializer &dser) : blob_(dser.data()->clone()) {}
-  ~Value() { delete blob_; }
-
-  CharArray *blob() { return blob_; }
-  size_t size() { return blob_->size(); }
-  Value *clone() { return new Value(*blob_); }
-
-  /** Steals a character array from this value. Must be deleted after **/
-  CharArray *steal() {
-    CharArray *give = blob_;
+  Value(Buffer *blob) : blob_(new Blob(blob)) {}
+  Value(Buffer &blob) : blob_(new Blob(blob.clone())) {}
+  Value(Deserializer &dser) : blob_(new Blob(dser.data()->clone())) {}
+  Value(Blob *blob) : blob_(blob->retain()) {}
+  ~Value() {
+    if (blob_ != nullptr)
+      blob_->release();
+  }
+
+  /** Gets the bytes of this value (read-only; they may be shared). **/
+  Buffer *blob() { return blob_->data_; }
+  size_t size() { return blob()->size(); }
+  Value *clone() { return new Value(blob_); }
+
+  /** Steals a character array from this value. Must be deleted after. The
+   * bytes are only copied if another value still shares them. **/
+  Buffer *steal() {
+    Buffer *give;
+    if (blob_->refs_ == 1) {
+      give = blob_->data_;
+      blob_->data_ = nullptr;
+    } else {
+      give = blob_->data_->clone();
+    }
+    blob_->release();
     blob_ = nullptr;
     return give;
   }
@@ -70,18 +174,16 @@ public:
   /** Serializes a value into a serializer. **/
   void serialize(Serializer &ser) {
     ser.write(blob()->size());
-    for (size_t i = 0; i < blob()->size(); i++) {
-      ser.write(blob()->get(i));
-    }
+    ser.write(blob()->data(), blob()->size());
   }
 
   /** Deserializes a value from a deserializer. **/
   static Value *deserialize(Deserializer &dser) {
     size_t len = dser.read_size_t();
-    CharArray *blob = new CharArray();
-    for (size_t i = 0; i < len; i++) {
-      blob->push_back(dser.read_char());
-    }
-    return new Value(blob);
+    return new Value(dser.read_buffer(len));
   }
-};
\ No newline at end of file
+};
+
+/** Here are arrays of keys and values. **/
+generate_object_classarray(KeyArray, Key);
+generate_object_classarray(ValueArray, Value);
@@ -4,37 +4,158 @@
 #include "../client/arg.h"
 #include "../client/network.h"
 #include "../utils/map.h"
+#include "cache.h"
+#include "future.h"
 #include "kv.h"
+#include "rows.h"
 
 /** Forward declaration of DataFrame. **/
 class DataFrame;
 
 /** Generates a non-concurrent KV-map **/
-generate_object_classarray(KeyArray, Key);
-generate_object_classarray(ValueArray, Value);
-generate_classmap(KVMap, KVNode, KeyArray, ValueArray, Key *, Value *);
+generate_classmap(KVMap, KeyArray, ValueArray, Key *, Value *);
 
-/** Represents a concurrent map from Keys to size_t. **/
-class ConcurrentKVMap : public KVMap {
+/** Mapping from request ids to the futures waiting on them. **/
+generate_classmap(SFMap, SizeTArray, FutureArray, size_t, Future *);
+
+/** The number of independently locked shards in a ConcurrentKVMap. **/
+static const size_t KV_SHARD_BITS = 4;
+static const size_t KV_SHARDS = 1 << KV_SHARD_BITS;
+
+/** Represents a concurrent map from Keys to Values. Keys are spread across
+ * shards that each have their own reader-writer lock, so readers never block
+ * each other and a put only blocks the shard it lands in.
+ * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
+class ConcurrentKVMap : public Object {
 public:
-  Lock lock_;
+  KVMap shards_[KV_SHARDS];
+  ReadWriteLock locks_[KV_SHARDS];
+
+  virtual ~ConcurrentKVMap() {}
 
   void put(Key *k, Value *v) {
+    size_t s = shard_(k);
+    locks_[s].write_lock();
+    shards_[s].put(k, v);
+    locks_[s].unlock();
+    stored_(k);
+  }
+
+  Value *get(Key *k) {
+    size_t s = shard_(k);
+    locks_[s].read_lock();
+    Value *hold = shards_[s].get(k);
+    locks_[s].unlock();
+    return hold;
+  }
+
+  bool contains_key(Key *k) {
+    size_t s = shard_(k);
+    locks_[s].read_lock();
+    bool hold = shards_[s].contains_key(k);
+    locks_[s].unlock();
+    return hold;
+  }
+
+  Value *remove(Key *k) {
+    size_t s = shard_(k);
+    locks_[s].write_lock();
+    Value *hold = shards_[s].remove(k);
+    locks_[s].unlock();
+    return hold;
+  }
+
+  /** Gets every key in the map. The array is owned by the caller, the keys
+   * are owned by the map. **/
+  KeyArray *keys() {
+    KeyArray *ka = new KeyArray();
+    for (size_t s = 0; s < KV_SHARDS; s++) {
+      locks_[s].read_lock();
+      KeyArray *shard_keys = shards_[s].keys();
+      locks_[s].unlock();
+      ka->concat(shard_keys);
+      delete shard_keys;
+    }
+    return ka;
+  }
+
+  size_t size() {
+    size_t total = 0;
+    for (size_t s = 0; s < KV_SHARDS; s++) {
+      locks_[s].read_lock();
+      total += shards_[s].size();
+      locks_[s].unlock();
+    }
+    return total;
+  }
+
+  /** Called (without any lock held) after a key has been stored. **/
+  virtual void stored_(Key *k) {}
+
+  /** Picks a shard from the high bits of the key's mixed hash, leaving the
+   * low bits for the bucket index within the shard. **/
+  size_t shard_(Key *k) {
+    size_t mixed = k->hash() * 0x9E3779B97F4A7C15ULL;
+    return mixed >> (sizeof(size_t) * 8 - KV_SHARD_BITS);
+  }
+};
+
+/** A get (or multi-get) from another node that is waiting on keys which have
+ * not been stored yet.
+ * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
+class PendingGet : public Object {
+public:
+  Message *request_; // owned; a Get or a MultiGet
+  size_t missing_;   // how many of the request's keys are still absent
+
+  PendingGet(Message *request) : request_(request), missing_(0) {}
+  ~PendingGet() { delete request_; }
+};
+
+/** Mapping from a missing key to the gets waiting on it. **/
+generate_object_classarray(PendingGetArray, PendingGet);
+generate_classmap(WaiterMap, KeyArray, Array, Key *, PendingGetArray *);
+
+/** The RemoteRowers a node knows how to run, by name. Every node registers
+ * the same rowers so that any of them can rebuild one sent by name.
+ * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
+class RowerRegistry : public Object {
+public:
+  Lock lock_;
+  Map rowers_; // name -> prototype; the prototypes are owned
+
+  ~RowerRegistry() {
+    Array *prototypes = rowers_.values();
+    for (size_t i = 0; i < prototypes->size(); i++) {
+      delete prototypes->get(i);
+    }
+    delete prototypes;
+  }
+
+  /** Registers a rower under its name, consuming it. **/
+  void add(RemoteRower *prototype) {
+    String name(prototype->name());
     lock_.lock();
-    KVMap::put(k, v);
+    if (rowers_.contains_key(&name))
+      delete rowers_.get(&name);
+    rowers_.put(&name, prototype);
     lock_.unlock();
   }
 
-  Value *get(Key *k) {
+  /** Creates a fresh rower of the kind registered under name, which the
+   * caller owns. **/
+  RemoteRower *create(String *name) {
     lock_.lock();
-    Value *hold = KVMap::get(k);
+    assert(rowers_.contains_key(name));
+    RemoteRower *prototype = dynamic_cast<RemoteRower *>(rowers_.get(name));
     lock_.unlock();
-    return hold;
+    return prototype->clone();
   }
 };
 
-/** Forward declaration of KVStore servicer. **/
+/** Forward declaration of KVStore servicer and worker. **/
 class KVStoreServicer;
+class KVStoreWorker;
 
 /** Represents a Key-Value Store from a network. **/
 class KVStore : public ConcurrentKVMap {
@@ -42,7 +163,12 @@ public:
   size_t index_;
   Network *network_ = nullptr;
   KVStoreServicer *servicer_ = nullptr;
-  ConcurrentMessageQueue replies;
+  std::atomic<size_t> next_id_{1}; // 0 is reserved for unanswered messages
+  Lock waiters_lock_;
+  WaiterMap waiters_; // missing key -> gets waiting on it
+  ChunkCache cache_;  // chunks fetched from other nodes
+  RowerRegistry registry_;
+  KVStoreWorker *worker_ = nullptr; // runs rowers for other nodes
 
   /** Creates a KVStore at a given index and with a given network. **/
   KVStore(size_t index, Network *network) : index_(index), network_(network) {}
@@ -52,25 +178,115 @@ public:
       delete remove(ks->get(i));
     }
     delete ks;
+
+    // Gets that were never answered are dropped with the store.
+    PendingGetArray dropped;
+    ks = waiters_.keys();
+    for (size_t i = 0; i < ks->size(); i++) {
+      PendingGetArray *waiting = waiters_.remove(ks->get(i));
+      for (size_t j = 0; j < waiting->size(); j++) {
+        if (dropped.index_of(waiting->get(j)) > dropped.size())
+          dropped.push_back(waiting->get(j));
+      }
+      delete waiting;
+    }
+    delete ks;
+    for (size_t i = 0; i < dropped.size(); i++) {
+      delete dropped.get(i);
+    }
   }
 
   /** Gets the index of the keyvalue store **/
   size_t index() { return index_; }
 
+  /** Gets the cache of remote chunks shared by this node's DataFrames. **/
+  ChunkCache *cache() { return &cache_; }
+
+  /** Gets the rowers this node can run for others. **/
+  RowerRegistry *registry() { return &registry_; }
+
   /** Gets a distributed dataframe that is locally hosted on this KV store.  **/
   DataFrame *get(Key *key);
 
   /** Gets a distributed dataframe that is *not* hosted at this store. **/
   DataFrame *get_and_wait(Key *key);
 
-  /** Stores a key and value at the desired node. **/
+  /** Stores a key and value at the desired node, dropping any copy of the
+   * key this node has cached. **/
   void put(Key *key, Value *value);
 
+  /** Requests the value at the given key without blocking. The returned
+   * future is owned by the caller and is answered by a Reply once the key
+   * has been stored, even if it is stored on this node. **/
+  Future *get_async(Key *key);
+
+  /** Stores a key and value at the desired node without blocking. The
+   * returned future is owned by the caller and completes once the value has
+   * been stored. **/
+  Future *put_async(Key *key, Value *value);
+
+  /** Requests the values of many keys that all live on the same node
+   * without blocking. The keys are external; the returned future is owned by
+   * the caller and is answered by a MultiReply once every key is stored. **/
+  Future *get_many_async(KeyArray *keys);
+
+  /** Gets the values of many keys with one round trip per node that holds
+   * them. The keys are external; the returned array and its values are owned
+   * by the caller and are in the same order as the keys. **/
+  ValueArray *get_many(KeyArray *keys);
+
+  /** Asks the node storing the columns of one chunk for the rows that satisfy
+   * the predicate, without blocking. The keys and predicate are external; the
+   * returned future is owned by the caller and is answered by a MultiReply of
+   * the filtered columns. **/
+  Future *filter_async(KeyArray *keys, Predicate *pred);
+
+  /** Filters the columns of a chunk stored on this node. **/
+  MultiReply *filter_locally_(KeyArray *keys, Predicate *pred);
+
+  /** Answers a Filter whose keys are all stored here, consuming it. Runs on
+   * the worker. **/
+  void filter_(Filter *request);
+
+  /** Asks a node to run a fresh rower of the same kind as the given one
+   * over the chunks of the dataframe at key that the node stores. Both are
+   * external; the returned future is owned by the caller and is answered by
+   * a Result. **/
+  Future *execute_async(size_t node, Key *key, RemoteRower *rower);
+
+  /** Runs a rower for another node and answers with its final state,
+   * consuming the request. **/
+  void execute_(Execute *request);
+
+  /** Hands an Execute or Filter to the worker thread, consuming it. **/
+  void defer_(Message *request);
+
+  /** Stores many key and value pairs with one message per node. The keys are
+   * external, the values (but not the arrays) are consumed. **/
+  void put_many(KeyArray *keys, ValueArray *values);
+
   /** Private methods on the Key-Value store that return Values. **/
   Value *get_value(Key *key) { return ConcurrentKVMap::get(key); }
   Value *get_and_wait_value(Key *key);
 
-  /** Starts/stops a thread that services incoming requests on the network. **/
+  /** Answers a Get or MultiGet, from this or another node, as soon as all
+   * of its keys have been stored here, consuming the request. **/
+  void answer_when_stored(Message *request);
+
+  /** Replies to a request whose keys are all present, consuming it. **/
+  void answer_(Message *request);
+
+  /** Sends an answer to the node that made the request, consuming it. **/
+  void reply_(Message *rep);
+
+  /** Answers the gets that were only waiting on the given key. **/
+  void stored_(Key *key);
+
+  /** Returns a fresh id for a request made from this node. **/
+  size_t next_request_id_() { return next_id_++; }
+
+  /** Starts/stops the threads that service incoming requests on the
+   * network. **/
   void start_service();
   void stop_service();
   void wait_to_close();
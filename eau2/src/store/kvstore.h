@@ -14,7 +14,7 @@ DataFrame *KVStore::get(Key *key) {
   assert(contains_key(key));
 
   // Load data from local storage.
-  Value *from = KVMap::get(key);
+  Value *from = get_value(key);
   Deserializer dser(*from->blob());
   Schema *schema = Schema::deserialize(dser);
 
@@ -32,10 +32,9 @@ DataFrame *KVStore::get_and_wait(Key *key) {
 
   // Load data from off this node
   Value *from = get_and_wait_value(key);
-  Deserializer dser(from->steal());
-  delete from;
-
+  Deserializer dser(*from->blob());
   Schema *schema = Schema::deserialize(dser);
+  delete from;
 
   // Let this dataframe know about its actual dimensions.
   DataFrame *df = new DataFrame(*schema, this);
@@ -44,32 +43,6 @@ DataFrame *KVStore::get_and_wait(Key *key) {
   return df;
 }
 
-/** Another thread whose sole job is to check to see if the given key has
- * arrived.
- * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
-class KVStoreReplier : public Thread {
-public:
-  size_t index_;
-  KVStore *store_;
-  Network *network_;
-  Get *get_;
-
-  KVStoreReplier(size_t index, KVStore *store, Network *network, Get *get)
-      : index_(index), store_(store), network_(network), get_(get) {}
-  ~KVStoreReplier() { delete get_; }
-
-  void run() {
-    while (!store_->contains_key(get_->key())) {
-      Thread::sleep(10);
-    }
-    Value *value = store_->get_value(get_->key());
-    Reply *rep = new Reply(get_->key()->clone(), value->clone());
-    rep->init(index_, get_->sender(), 0);
-    network_->send_msg(rep);
-  }
-};
-generate_object_classarray(KVStoreReplierArray, KVStoreReplier);
-
 /** Represents a thread that listens and services requests for a KVStore.
  * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
 class KVStoreServicer : public Thread {
@@ -78,18 +51,10 @@ public:
   KVStore *store_;
   Network *network_;
   Lock lock_;
-  Value *cur_value_ = nullptr;
-  KVStoreReplierArray repliers;
+  SFMap pending_; // request id -> future waiting on its answer
 
   KVStoreServicer(size_t index, KVStore *store, Network *network)
       : index_(index), store_(store), network_(network) {}
-  ~KVStoreServicer() {
-    for (size_t i = 0; i < repliers.size(); i++) {
-      KVStoreReplier *replier = repliers.get(i);
-      replier->join();
-      delete replier;
-    }
-  }
 
   /** Begins the service thread. **/
   void run() {
@@ -103,8 +68,21 @@ public:
       case MsgKind::Get:
         handle_get(dynamic_cast<Get *>(msg));
         break;
+      case MsgKind::MultiPut:
+        handle_multi_put(dynamic_cast<MultiPut *>(msg));
+        break;
+      case MsgKind::MultiGet:
+      case MsgKind::Filter:
+        handle_multi_get(dynamic_cast<MultiGet *>(msg));
+        break;
+      case MsgKind::Execute:
+        store_->defer_(msg);
+        break;
       case MsgKind::Reply:
-        handle_reply(dynamic_cast<Reply *>(msg));
+      case MsgKind::Ack:
+      case MsgKind::MultiReply:
+      case MsgKind::Result:
+        handle_answer(msg);
         break;
       case MsgKind::Kill:
         delete msg;
@@ -121,17 +99,12 @@ public:
     }
   }
 
-  /** Get the next value. **/
-  Value *next_value() {
+  /** Registers the future that the answer to the given request completes.
+   * Must be called before the request is sent. **/
+  void expect(size_t id, Future *future) {
     lock_.lock();
-    while (cur_value_ == nullptr) {
-      lock_.wait();
-    }
-    assert(cur_value_ != nullptr);
-    Value *hold = cur_value_;
-    cur_value_ = nullptr;
+    pending_.put(id, future);
     lock_.unlock();
-    return hold;
   }
 
   /** Handles reception of a put message by placing the key and value in local
@@ -140,32 +113,95 @@ public:
     assert(put->target() == index_);
     assert(put->key()->node() == index_);
     store_->put(put->key(), put->value()->clone());
+    acknowledge_(put);
     delete put;
   }
 
+  /** Handles reception of a multi-put by storing every pair locally. **/
+  void handle_multi_put(MultiPut *put) {
+    assert(put->target() == index_);
+    for (size_t i = 0; i < put->keys()->size(); i++) {
+      assert(put->keys()->get(i)->node() == index_);
+      store_->put(put->keys()->get(i), put->steal_value(i));
+    }
+    acknowledge_(put);
+    delete put;
+  }
+
+  /** Acknowledges a request if its sender is waiting on it. **/
+  void acknowledge_(Message *request) {
+    if (request->id_ == 0)
+      return;
+    Message *ack = new Ack();
+    ack->init(index_, request->sender(), request->id_);
+    network_->send_msg(ack);
+  }
+
   /** Handles reception of a get message by replying back with the data of the
    * message. **/
   void handle_get(Get *get) {
     assert(get->target() == index_);
     assert(get->key()->node() == index_);
-    KVStoreReplier *r = new KVStoreReplier(index_, store_, network_, get);
-    r->start();
-    repliers.push_back(r);
+    store_->answer_when_stored(get);
   }
 
-  /** Handles the reception of a reply message by adding it to the queue. **/
-  void handle_reply(Reply *reply) {
+  /** Handles reception of a multi-get or filter by replying with all of the
+   * (filtered) values once they are present. **/
+  void handle_multi_get(MultiGet *get) {
+    assert(get->target() == index_);
+    store_->answer_when_stored(get);
+  }
+
+  /** Handles the reception of a reply or acknowledgement by completing the
+   * future of the request with the same id. **/
+  void handle_answer(Message *answer) {
     lock_.lock();
-    cur_value_ = reply->value()->clone();
-    lock_.notify_all();
+    assert(pending_.contains_key(answer->id_));
+    Future *future = pending_.remove(answer->id_);
     lock_.unlock();
-    delete reply;
+    future->complete(answer);
+  }
+};
+
+/** Runs the requests that take too long to handle on the servicer, one at a
+ * time and in the order they arrived, so the servicer can keep answering the
+ * gets they make. Stops on a Kill.
+ * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
+class KVStoreWorker : public Thread {
+public:
+  KVStore *store_;
+  ConcurrentMessageQueue queue_; // owned; requests waiting to be run
+
+  KVStoreWorker(KVStore *store) : store_(store) {}
+
+  /** Queues a request, consuming it. **/
+  void push(Message *request) { queue_.push(request); }
+
+  void run() {
+    while (true) {
+      Message *request = queue_.pop();
+      switch (request->kind()) {
+      case MsgKind::Execute:
+        store_->execute_(dynamic_cast<Execute *>(request));
+        break;
+      case MsgKind::Filter:
+        store_->filter_(dynamic_cast<Filter *>(request));
+        break;
+      case MsgKind::Kill:
+        delete request;
+        return;
+      default:
+        assert(false);
+      }
+    }
   }
 };
 
 /** Starts a thread that services incoming requests on the network. **/
 void KVStore::start_service() {
   servicer_ = new KVStoreServicer(index_, this, network_);
+  worker_ = new KVStoreWorker(this);
+  worker_->start();
   servicer_->start();
 }
 
@@ -177,16 +213,145 @@ void KVStore::stop_service() {
 }
 
 /** Waits on the servicer thread to close. This is done when the servicer
- * receives a kill message. **/
+ * receives a kill message. The worker then finishes what it was handed and
+ * stops too. **/
 void KVStore::wait_to_close() {
   servicer_->join();
   delete servicer_;
+  Message *kill = new Kill();
+  kill->init(index_, index_, 0);
+  worker_->push(kill);
+  worker_->join();
+  delete worker_;
+}
+
+/** Hands a request to the worker, so the servicer is not held up. **/
+void KVStore::defer_(Message *request) { worker_->push(request); }
+
+/** Runs a fresh rower for another node over the chunks of a dataframe
+ * stored here, then answers with the rower's final state. **/
+void KVStore::execute_(Execute *request) {
+  RemoteRower *rower = registry_.create(request->rower());
+
+  DataFrame *df = get_and_wait(request->key());
+  df->local_map(*rower);
+  delete df;
+
+  Serializer ser;
+  rower->serialize(ser);
+  delete rower;
+  Value *state = new Value(ser.steal());
+  Message *result = new Result(request->key()->clone(), state);
+  result->init(index_, request->sender(), request->id_);
+  reply_(result);
+  delete request;
+}
+
+/** Asks another node to run a fresh rower of the same kind over its
+ * chunks. **/
+Future *KVStore::execute_async(size_t node, Key *key, RemoteRower *rower) {
+  assert(node != index_);
+  Future *future = new Future();
+  size_t id = next_request_id_();
+  Message *execute = new Execute(key->clone(), new String(rower->name()));
+  execute->init(index_, node, id);
+  servicer_->expect(id, future);
+  network_->send_msg(execute);
+  return future;
+}
+
+/** Answers a get from any node once all of its keys are present. **/
+void KVStore::answer_when_stored(Message *request) {
+  KeyArray keys;
+  if (request->kind() == MsgKind::Get) {
+    keys.push_back(dynamic_cast<Get *>(request)->key());
+  } else {
+    keys.concat(dynamic_cast<MultiGet *>(request)->keys());
+  }
+
+  // Registering under the waiter lock means a concurrent put either sees
+  // the waiter or stored its key before we looked for it.
+  PendingGet *pending = nullptr;
+  waiters_lock_.lock();
+  for (size_t i = 0; i < keys.size(); i++) {
+    Key *key = keys.get(i);
+    if (contains_key(key))
+      continue;
+    if (pending == nullptr)
+      pending = new PendingGet(request);
+    if (!waiters_.contains_key(key))
+      waiters_.put(key, new PendingGetArray());
+    waiters_.get(key)->push_back(pending);
+    pending->missing_++;
+  }
+  waiters_lock_.unlock();
+
+  if (pending == nullptr)
+    answer_(request);
+}
+
+/** Replies to a request whose keys are all present. Filters are left to the
+ * worker, since evaluating them would hold up the thread that stored the
+ * last key, which may be the servicer. **/
+void KVStore::answer_(Message *request) {
+  if (request->kind() == MsgKind::Filter)
+    return defer_(request);
+  Message *rep;
+  if (request->kind() == MsgKind::Get) {
+    Key *key = dynamic_cast<Get *>(request)->key();
+    rep = new Reply(key->clone(), get_value(key)->clone());
+  } else {
+    KeyArray *requested = dynamic_cast<MultiGet *>(request)->keys();
+    KeyArray *keys = new KeyArray();
+    ValueArray *values = new ValueArray();
+    for (size_t i = 0; i < requested->size(); i++) {
+      keys->push_back(requested->get(i)->clone());
+      values->push_back(get_value(requested->get(i))->clone());
+    }
+    rep = new MultiReply(keys, values);
+  }
+  rep->init(index_, request->sender(), request->id_);
+  reply_(rep);
+  delete request;
+}
+
+/** Sends an answer to the node that asked for it. Answers to this node's own
+ * requests complete their futures without going through the network. **/
+void KVStore::reply_(Message *rep) {
+  if (rep->target() == index_)
+    servicer_->handle_answer(rep);
+  else
+    network_->send_msg(rep);
+}
+
+/** Answers the gets that were only waiting on the given key. **/
+void KVStore::stored_(Key *key) {
+  PendingGetArray ready;
+  waiters_lock_.lock();
+  if (waiters_.contains_key(key)) {
+    PendingGetArray *waiting = waiters_.remove(key);
+    for (size_t i = 0; i < waiting->size(); i++) {
+      PendingGet *pending = waiting->get(i);
+      if (--pending->missing_ == 0)
+        ready.push_back(pending);
+    }
+    delete waiting;
+  }
+  waiters_lock_.unlock();
+
+  for (size_t i = 0; i < ready.size(); i++) {
+    PendingGet *pending = ready.get(i);
+    answer_(pending->request_);
+    pending->request_ = nullptr;
+    delete pending;
+  }
 }
 
 /** Stores a key and value at the desired node. **/
 void KVStore::put(Key *key, Value *value) {
   if (key->node() == index_)
     return ConcurrentKVMap::put(key, value);
+  cache_.invalidate(key);
   // printf("PUT K(%s) from (%d) to (%d)\n", key->key()->c_str(), (int)index(),
   //        (int)key->node());
   Message *put = new Put(key->clone(), value);
@@ -194,17 +359,181 @@ void KVStore::put(Key *key, Value *value) {
   network_->send_msg(put);
 }
 
+/** Stores a key and value at the desired node without blocking. **/
+Future *KVStore::put_async(Key *key, Value *value) {
+  Future *future = new Future();
+  if (key->node() == index_) {
+    ConcurrentKVMap::put(key, value);
+    future->complete(new Ack());
+    return future;
+  }
+
+  cache_.invalidate(key);
+  size_t id = next_request_id_();
+  Message *put = new Put(key->clone(), value);
+  put->init(index_, key->node(), id);
+  servicer_->expect(id, future);
+  network_->send_msg(put);
+  return future;
+}
+
+/** Requests a value from across the network without blocking. A key stored
+ * here is answered as soon as it is present, like a get from another node. **/
+Future *KVStore::get_async(Key *key) {
+  Future *future = new Future();
+  size_t id = next_request_id_();
+  Message *get = new Get(key->clone());
+  get->init(index_, key->node(), id);
+  servicer_->expect(id, future);
+  if (key->node() == index_)
+    answer_when_stored(get);
+  else
+    network_->send_msg(get);
+  return future;
+}
+
 /** Reaches across the network and acquires a value from another node. **/
 Value *KVStore::get_and_wait_value(Key *key) {
-  // printf("GET K(%s) from (%d) to (%d)\n", key->key()->c_str(),
-  // (int)key->node(),
-  //        (int)index());
-  if (key->node() == index_)
-    return get_value(key);
+  Future *future = get_async(key);
+  Value *value = future->steal_value();
+  delete future;
+  return value;
+}
 
-  Message *get = new Get(key->clone());
-  get->init(index_, key->node(), 0);
-  network_->send_msg(get);
+/** Filters the columns of a chunk that is stored here. **/
+MultiReply *KVStore::filter_locally_(KeyArray *keys, Predicate *pred) {
+  KeyArray *copies = new KeyArray();
+  ValueArray columns;
+  for (size_t i = 0; i < keys->size(); i++) {
+    copies->push_back(keys->get(i)->clone());
+    columns.push_back(get_value(keys->get(i)));
+  }
+  return new MultiReply(copies, DataFrame::filter_chunk(&columns, *pred));
+}
+
+/** Answers a Filter whose keys are all present, consuming it. **/
+void KVStore::filter_(Filter *request) {
+  Message *rep = filter_locally_(request->keys(), request->pred());
+  rep->init(index_, request->sender(), request->id_);
+  reply_(rep);
+  delete request;
+}
+
+/** Requests the rows of a chunk that satisfy a predicate. A chunk stored
+ * here is filtered by the worker once all of its columns are present, like
+ * one stored on another node. **/
+Future *KVStore::filter_async(KeyArray *keys, Predicate *pred) {
+  assert(keys->size() > 0);
+  size_t node = keys->get(0)->node();
+  KeyArray *copies = new KeyArray();
+  for (size_t i = 0; i < keys->size(); i++) {
+    assert(keys->get(i)->node() == node);
+    copies->push_back(keys->get(i)->clone());
+  }
+
+  Future *future = new Future();
+  size_t id = next_request_id_();
+  Message *filter = new Filter(copies, pred->clone());
+  filter->init(index_, node, id);
+  servicer_->expect(id, future);
+  if (node == index_)
+    answer_when_stored(filter);
+  else
+    network_->send_msg(filter);
+  return future;
+}
+
+/** Requests the values of many keys that live on one node. Keys stored here
+ * are answered once all of them are present. **/
+Future *KVStore::get_many_async(KeyArray *keys) {
+  assert(keys->size() > 0);
+  size_t node = keys->get(0)->node();
+  KeyArray *copies = new KeyArray();
+  for (size_t i = 0; i < keys->size(); i++) {
+    assert(keys->get(i)->node() == node);
+    copies->push_back(keys->get(i)->clone());
+  }
+
+  Future *future = new Future();
+  size_t id = next_request_id_();
+  Message *get = new MultiGet(copies);
+  get->init(index_, node, id);
+  servicer_->expect(id, future);
+  if (node == index_)
+    answer_when_stored(get);
+  else
+    network_->send_msg(get);
+  return future;
+}
 
-  return servicer_->next_value();
+/** Gets the values of many keys, batching them by the node that holds them.
+ * **/
+ValueArray *KVStore::get_many(KeyArray *keys) {
+  // Send one request per distinct node before waiting on any of them.
+  SizeTArray nodes;
+  FutureArray requests;
+  for (size_t i = 0; i < keys->size(); i++) {
+    size_t node = keys->get(i)->node();
+    if (nodes.index_of(node) < nodes.size())
+      continue;
+    KeyArray group;
+    for (size_t j = i; j < keys->size(); j++) {
+      if (keys->get(j)->node() == node)
+        group.push_back(keys->get(j));
+    }
+    nodes.push_back(node);
+    requests.push_back(get_many_async(&group));
+  }
+
+  // Put the answers back into the order of the keys.
+  ValueArray *values = new ValueArray();
+  SizeTArray taken; // how many values have been used from each answer
+  for (size_t i = 0; i < nodes.size(); i++) {
+    taken.push_back(0);
+  }
+  for (size_t i = 0; i < keys->size(); i++) {
+    size_t n = nodes.index_of(keys->get(i)->node());
+    MultiReply *r = dynamic_cast<MultiReply *>(requests.get(n)->reply());
+    values->push_back(r->steal_value(taken.get(n)));
+    taken.set(n, taken.get(n) + 1);
+  }
+  for (size_t i = 0; i < requests.size(); i++) {
+    delete requests.get(i);
+  }
+  return values;
+}
+
+/** Stores many key and value pairs, batching them by their node. **/
+void KVStore::put_many(KeyArray *keys, ValueArray *values) {
+  assert(keys->size() == values->size());
+  SizeTArray nodes;
+  for (size_t i = 0; i < keys->size(); i++) {
+    size_t node = keys->get(i)->node();
+    if (nodes.index_of(node) < nodes.size())
+      continue;
+    nodes.push_back(node);
+
+    KeyArray *group_keys = new KeyArray();
+    ValueArray *group_values = new ValueArray();
+    for (size_t j = i; j < keys->size(); j++) {
+      if (keys->get(j)->node() != node)
+        continue;
+      group_keys->push_back(keys->get(j)->clone());
+      group_values->push_back(values->get(j));
+      if (node != index_)
+        cache_.invalidate(keys->get(j));
+    }
+
+    if (node == index_) {
+      for (size_t j = 0; j < group_keys->size(); j++) {
+        ConcurrentKVMap::put(group_keys->get(j), group_values->get(j));
+      }
+      delete_all(group_keys);
+      delete group_values; // the values now belong to the store
+      continue;
+    }
+    Message *put = new MultiPut(group_keys, group_values);
+    put->init(index_, node, 0);
+    network_->send_msg(put);
+  }
 }
@@ -0,0 +1,184 @@
+// lang: CwC
+#pragma once
+
+#include "rows.h"
+
+/** The comparisons and connectives a Predicate is built from. **/
+enum class PredKind {
+  Less,
+  LessEq,
+  Equal,
+  NotEqual,
+  GreaterEq,
+  Greater,
+  And,
+  Or
+};
+
+/** A condition on the rows of a dataframe that can be sent to the node that
+ * stores them. A leaf compares one column against a constant of the same
+ * type; an inner node joins two predicates with And or Or. Missing values
+ * never satisfy a comparison.
+ * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
+class Predicate : public Object {
+public:
+  PredKind kind_;
+  size_t col_ = 0;
+  char type_ = 0; // the constant's type: 'B', 'I', 'F' or 'S'
+  bool b_ = false;
+  int i_ = 0;
+  float f_ = 0;
+  String *s_ = nullptr;        // owned
+  Predicate *left_ = nullptr;  // owned
+  Predicate *right_ = nullptr; // owned
+
+  /** Builds a comparison of column col against a constant. A String
+   * constant is consumed. **/
+  Predicate(PredKind kind, size_t col, bool b)
+      : kind_(kind), col_(col), type_('B'), b_(b) {}
+  Predicate(PredKind kind, size_t col, int i)
+      : kind_(kind), col_(col), type_('I'), i_(i) {}
+  Predicate(PredKind kind, size_t col, float f)
+      : kind_(kind), col_(col), type_('F'), f_(f) {}
+  Predicate(PredKind kind, size_t col, String *s)
+      : kind_(kind), col_(col), type_('S'), s_(s) {}
+
+  /** Joins two predicates with And or Or, consuming both. **/
+  Predicate(PredKind kind, Predicate *left, Predicate *right)
+      : kind_(kind), left_(left), right_(right) {
+    assert(kind == PredKind::And || kind == PredKind::Or);
+  }
+
+  ~Predicate() {
+    delete s_;
+    delete left_;
+    delete right_;
+  }
+
+  /** Whether the row satisfies this predicate. **/
+  bool test(Row &row) {
+    switch (kind_) {
+    case PredKind::And:
+      return left_->test(row) && right_->test(row);
+    case PredKind::Or:
+      return left_->test(row) || right_->test(row);
+    default:
+      break;
+    }
+    if (row.get_missing(col_))
+      return false;
+    int cmp = compare_(row);
+    switch (kind_) {
+    case PredKind::Less:
+      return cmp < 0;
+    case PredKind::LessEq:
+      return cmp <= 0;
+    case PredKind::Equal:
+      return cmp == 0;
+    case PredKind::NotEqual:
+      return cmp != 0;
+    case PredKind::GreaterEq:
+      return cmp >= 0;
+    default:
+      return cmp > 0;
+    }
+  }
+
+  /** Compares the row's value to the constant: negative if it is smaller,
+   * zero if equal and positive if greater. **/
+  int compare_(Row &row) {
+    switch (type_) {
+    case 'B':
+      return (int)row.get_bool(col_) - (int)b_;
+    case 'I': {
+      int v = row.get_int(col_);
+      return (v < i_) ? -1 : (v > i_);
+    }
+    case 'F': {
+      float v = row.get_float(col_);
+      return (v < f_) ? -1 : (v > f_);
+    }
+    default:
+      return strcmp(row.get_string(col_)->c_str(), s_->c_str());
+    }
+  }
+
+  Predicate *clone() {
+    switch (kind_) {
+    case PredKind::And:
+    case PredKind::Or:
+      return new Predicate(kind_, left_->clone(), right_->clone());
+    default:
+      break;
+    }
+    switch (type_) {
+    case 'B':
+      return new Predicate(kind_, col_, b_);
+    case 'I':
+      return new Predicate(kind_, col_, i_);
+    case 'F':
+      return new Predicate(kind_, col_, f_);
+    default:
+      return new Predicate(kind_, col_, s_->clone());
+    }
+  }
+
+  /** Serializes a predicate tree in prefix order. **/
+  void serialize(Serializer &ser) {
+    ser.write((size_t)kind_);
+    if (kind_ == PredKind::And || kind_ == PredKind::Or) {
+      left_->serialize(ser);
+      right_->serialize(ser);
+      return;
+    }
+    ser.write(col_);
+    ser.write(type_);
+    switch (type_) {
+    case 'B':
+      ser.write(b_);
+      break;
+    case 'I':
+      ser.write(i_);
+      break;
+    case 'F':
+      ser.write(f_);
+      break;
+    default:
+      ser.write(s_);
+      break;
+    }
+  }
+
+  /** Deserializes a predicate tree written by serialize. **/
+  static Predicate *deserialize(Deserializer &dser) {
+    PredKind kind = static_cast<PredKind>(dser.read_size_t());
+    if (kind == PredKind::And || kind == PredKind::Or) {
+      Predicate *left = Predicate::deserialize(dser);
+      Predicate *right = Predicate::deserialize(dser);
+      return new Predicate(kind, left, right);
+    }
+    size_t col = dser.read_size_t();
+    switch (dser.read_char()) {
+    case 'B':
+      return new Predicate(kind, col, dser.read_bool());
+    case 'I':
+      return new Predicate(kind, col, dser.read_int());
+    case 'F':
+      return new Predicate(kind, col, dser.read_float());
+    default:
+      return new Predicate(kind, col, String::deserialize(dser));
+    }
+  }
+};
+
+/** A Rower that keeps the rows satisfying a predicate, for use with
+ * DataFrame::filter.
+ * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
+class PredicateRower : public Rower {
+public:
+  Predicate &pred_;
+
+  PredicateRower(Predicate &pred) : pred_(pred) {}
+
+  bool accept(Row &row) { return pred_.test(row); }
+};
@@ -1,6 +1,7 @@
 // lang: CwC
 #pragma once
 
+#include "../utils/bitset.h"
 #include "schema.h"
 
 /*****************************************************************************
@@ -41,12 +42,16 @@ class Row : public Object {
 public:
   Schema *scm_;
   ColumnArray cols_;
+  Bitset missing_; // a set bit marks a missing field
+  Bitset viewing_; // a set bit marks a string field shown by its view
+  String *views_;  // owned; a view per field, into external characters
   size_t row_idx_;
 
   /** Build a row following a schema. */
-  Row(Schema &scm) {
+  Row(Schema &scm) : missing_(scm.width(), true), viewing_(scm.width(), false) {
     row_idx_ = 0;
     scm_ = new Schema(scm);
+    views_ = new String[scm_->width()];
     for (size_t i = 0; i < scm_->width(); i++) {
       switch (scm_->col_type(i)) {
       case 'B':
@@ -71,20 +76,43 @@ public:
     for (size_t i = 0; i < scm_->width(); i++) {
       delete cols_.get(i);
     }
+    delete[] views_;
     delete scm_;
   }
 
   /** Setters: set the given column with the given value. Setting a column
    * with a value of the wrong type is undefined. */
-  void set(size_t col, int val) { cols_.get(col)->as_int()->set(0, val); }
-  void set(size_t col, float val) { cols_.get(col)->as_float()->set(0, val); }
-  void set(size_t col, bool val) { cols_.get(col)->as_bool()->set(0, val); }
+  void set(size_t col, int val) {
+    cols_.get(col)->as_int()->set(0, val);
+    missing_.set(col, false);
+  }
+  void set(size_t col, float val) {
+    cols_.get(col)->as_float()->set(0, val);
+    missing_.set(col, false);
+  }
+  void set(size_t col, bool val) {
+    cols_.get(col)->as_bool()->set(0, val);
+    missing_.set(col, false);
+  }
   /** Acquire ownership of the string. */
   void set(size_t col, String *val) {
     cols_.get(col)->as_string()->set(0, val);
+    missing_.set(col, val == nullptr);
+    viewing_.set(col, false);
+  }
+  /** Shows len terminated characters as the string of the given column
+   * without copying them. They must outlive the row's use of them, so a
+   * rower that keeps a string it was shown must clone it. */
+  void view(size_t col, char *cstr, size_t len) {
+    views_[col].view(cstr, len);
+    missing_.set(col, false);
+    viewing_.set(col, true);
   }
   /** Sets the given column to missing **/
-  void set_missing(size_t col) { cols_.get(col)->set_missing(0); }
+  void set_missing(size_t col) { missing_.set(col, true); }
+
+  /** Whether every field of the row has a value. **/
+  bool all_present() { return missing_.none(); }
 
   /** Set/get the index of this row (ie. its position in the dataframe.
    * This is only used for informational purposes, unused otherwise */
@@ -96,8 +124,12 @@ public:
   int get_int(size_t col) { return cols_.get(col)->as_int()->get(0); }
   bool get_bool(size_t col) { return cols_.get(col)->as_bool()->get(0); }
   float get_float(size_t col) { return cols_.get(col)->as_float()->get(0); }
-  String *get_string(size_t col) { return cols_.get(col)->as_string()->get(0); }
-  bool get_missing(size_t col) { return cols_.get(col)->is_missing(0); }
+  String *get_string(size_t col) {
+    if (viewing_.get(col))
+      return &views_[col];
+    return cols_.get(col)->as_string()->get(0);
+  }
+  bool get_missing(size_t col) { return missing_.get(col); }
 
   /** Number of fields in the row. */
   size_t width() { return scm_->width(); }
@@ -135,6 +167,127 @@ public:
   }
 };
 
+/*******************************************************************************
+ * Batch::
+ *
+ * A read-only view of up to CHUNK_SIZE consecutive rows of a dataframe, a
+ * column at a time, so that a rower can run a tight loop over each column
+ * instead of being handed a Row per row. Ints, floats and the codes of
+ * dictionary encoded strings are contiguous arrays; bools and the missing
+ * flags are Bitset words, with row i at bit i. Columns outside the
+ * projection are not loaded and must not be read. A batch, and the arrays it
+ * hands out, are only valid while the rower it was given to runs.
+ *
+ * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu
+ */
+class Batch : public Object {
+public:
+  Schema *scm_;       // external
+  ColumnArray *cols_; // external; the columns holding the rows
+  Bitset *columns_;   // external; the columns that are loaded
+  size_t start_;      // index in the dataframe of the first row
+  size_t offset_;     // index in the columns of the first row
+  size_t size_;       // number of rows
+
+  /** Views n rows of the columns, starting at offset, which must be a
+   * multiple of CHUNK_SIZE; the first one is row start of the dataframe. **/
+  Batch(Schema &scm, ColumnArray &cols, Bitset &columns, size_t start,
+        size_t offset, size_t n)
+      : scm_(&scm), cols_(&cols), columns_(&columns), start_(start),
+        offset_(offset), size_(n) {
+    assert(offset % CHUNK_SIZE == 0 && n <= CHUNK_SIZE);
+  }
+
+  size_t size() { return size_; }
+  size_t width() { return scm_->width(); }
+  size_t start() { return start_; }
+  bool loaded(size_t col) { return columns_->get(col); }
+
+  /** The values of an int or float column. The values of missing rows are
+   * unspecified. **/
+  const int *ints(size_t col) {
+    IntArray &vals = column_(col)->as_int()->vals_;
+    assert(vals.run_(offset_, size_) == size_);
+    return vals.at_(offset_);
+  }
+  const float *floats(size_t col) {
+    FloatArray &vals = column_(col)->as_float()->vals_;
+    assert(vals.run_(offset_, size_) == size_);
+    return vals.at_(offset_);
+  }
+
+  /** The words of a bool column, and of a column's missing flags. **/
+  const size_t *bool_words(size_t col) {
+    return column_(col)->as_bool()->vals_.words_ + word_offset_();
+  }
+  const size_t *missing_words(size_t col) {
+    return column_(col)->missing_.words_ + word_offset_();
+  }
+
+  /** The dictionary of a string column, or nullptr if it is not
+   * dictionary encoded. The dictionary is owned by the column. **/
+  DictStringColumn *dict(size_t col) {
+    return dynamic_cast<DictStringColumn *>(column_(col));
+  }
+
+  /** The codes of a dictionary encoded string column. **/
+  const int *codes(size_t col) {
+    IntArray &codes = dict(col)->codes_;
+    assert(codes.run_(offset_, size_) == size_);
+    return codes.at_(offset_);
+  }
+
+  /** Single values, for columns that are not worth a loop of their own. The
+   * string is owned by the column. **/
+  bool is_missing(size_t col, size_t i) {
+    return column_(col)->is_missing(offset_ + i);
+  }
+  bool get_bool(size_t col, size_t i) {
+    return column_(col)->as_bool()->get(offset_ + i);
+  }
+  String *get_string(size_t col, size_t i) {
+    return column_(col)->as_string()->get(offset_ + i);
+  }
+
+  /** Fills the row with the i-th row of the batch. Columns that are not
+   * loaded are missing. **/
+  void fill_row(size_t i, Row &row) {
+    row.set_idx(start_ + i);
+    for (size_t col = 0; col < width(); col++) {
+      if (!loaded(col) || is_missing(col, i)) {
+        row.set_missing(col);
+        continue;
+      }
+      switch (scm_->col_type(col)) {
+      case 'B':
+        row.set(col, get_bool(col, i));
+        break;
+      case 'I':
+        row.set(col, ints(col)[i]);
+        break;
+      case 'F':
+        row.set(col, floats(col)[i]);
+        break;
+      case 'S':
+        row.view(col, column_(col)->as_string()->chars_at(offset_ + i),
+                 column_(col)->as_string()->length_at(offset_ + i));
+        break;
+      default:
+        assert(false);
+        break;
+      }
+    }
+  }
+
+  Column *column_(size_t col) {
+    assert(loaded(col));
+    return cols_->get(col);
+  }
+
+  /** The word of a bitset holding the batch's first row. **/
+  size_t word_offset_() { return offset_ / Bitset::WORD_BITS; }
+};
+
 /*******************************************************************************
  *  Rower::
  *  An interface for iterating through each row of a data frame. The intent
@@ -151,16 +304,57 @@ public:
       should be kept. */
   virtual bool accept(Row &r) { return false; }
 
+  /** Called by the maps once per batch of consecutive rows. map hands a
+      rower its batches in order; under pmap each clone gets whichever
+      batches it takes, in no particular order. By default each row of the
+      batch is filled in turn and passed to accept(); rowers that can work a
+      column at a time override this. */
+  virtual void accept_batch(Batch &batch) {
+    Row row(*batch.scm_);
+    for (size_t i = 0; i < batch.size(); i++) {
+      batch.fill_row(i, row);
+      accept(row);
+    }
+  }
+
   /** Once traversal of the data frame is complete the rowers that were
       split off will be joined.  There will be one join per split. The
       original object will be the last to be called join on. The join
-     method is reponsible for cleaning up memory. */
+     method is reponsible for cleaning up memory. Since the clones of a
+     pmap cover arbitrary sets of rows, the join must give the same result
+     whichever rows each side saw. */
   virtual void join_delete(Rower *other) { delete other; }
 
-  /** Satisifies Object properties **/
+  /** Satisifies Object properties. A rower that returns nullptr cannot be
+      split, and pmap runs it on its own. **/
   virtual Rower *clone() { return nullptr; }
 };
 
+/*******************************************************************************
+ *  RemoteRower::
+ *  A Rower that can be shipped to the nodes storing a dataframe's chunks.
+ *  Every node registers the same rowers under the same names. Other nodes
+ *  run a fresh rower of the same name, whose final state comes back as
+ *  whatever serialize writes, is rebuilt from a fresh clone by restore, and
+ *  is combined with join_delete.
+ *
+ * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu
+ */
+class RemoteRower : public Rower {
+public:
+  /** The name this rower is registered under. **/
+  virtual const char *name() {
+    assert(false);
+    return nullptr;
+  }
+
+  /** Replaces the state of this rower with one written by serialize. **/
+  virtual void restore(Deserializer &dser) {}
+
+  /** Returns a fresh rower of the same kind, with no state. **/
+  virtual RemoteRower *clone() { return nullptr; }
+};
+
 /*******************************************************************************
  *  Writer::
  *  An interface for iterating through each row of a data frame, mutating each
@@ -1,6 +1,7 @@
 // lang: CwC
 #pragma once
 #include <assert.h>
+#include <cstring>
 
 #include "object.h"
 #include "string.h"
@@ -87,6 +88,61 @@ static const size_t CHUNK_SIZE = 16384; // 2^14 B
       num_elements_ = temp_num_elements;                                       \
     }                                                                          \
                                                                                \
+    /** Length of the contiguous run of storage starting at index. **/        \
+    size_t run_(size_t index, size_t n) {                                      \
+      return Util::min(n, CHUNK_SIZE - col_(index));                           \
+    }                                                                          \
+                                                                               \
+    /** The storage of the element at index, followed by the rest of its       \
+     * run. **/                                                                \
+    Stores *at_(size_t index) { return &elements_[row_(index)][col_(index)]; } \
+                                                                               \
+    /** Appends n elements copied from src, one memcpy per chunk. **/         \
+    virtual void append(const Stores *src, size_t n) {                         \
+      grow_to_fit_(num_elements_ + n);                                         \
+      for (size_t done = 0; done < n;) {                                       \
+        size_t i = num_elements_ + done, len = run_(i, n - done);              \
+        Stores *to = &elements_[row_(i)][col_(i)];                             \
+        memcpy(to, src + done, len * sizeof(Stores));                          \
+        done += len;                                                           \
+      }                                                                        \
+      num_elements_ += n;                                                      \
+    }                                                                          \
+                                                                               \
+    /** Copies n elements starting at index into dst, one memcpy per chunk. */ \
+    virtual void copy_to(size_t index, size_t n, Stores *dst) {                \
+      assert(index + n <= num_elements_);                                      \
+      for (size_t done = 0; done < n;) {                                       \
+        size_t i = index + done, len = run_(i, n - done);                      \
+        Stores *from = &elements_[row_(i)][col_(i)];                           \
+        memcpy(dst + done, from, len * sizeof(Stores));                        \
+        done += len;                                                           \
+      }                                                                        \
+    }                                                                          \
+                                                                               \
+    /** Writes the raw bytes of every element, one write per chunk. **/       \
+    virtual void serialize_raw(Serializer &ser) {                              \
+      ser.reserve(num_elements_ * sizeof(Stores));                             \
+      for (size_t i = 0; i < num_elements_;) {                                 \
+        size_t len = run_(i, num_elements_ - i);                               \
+        char *bytes = reinterpret_cast<char *>(&elements_[row_(i)][col_(i)]);  \
+        ser.write(bytes, len * sizeof(Stores));                                \
+        i += len;                                                              \
+      }                                                                        \
+    }                                                                          \
+                                                                               \
+    /** Appends n elements written by serialize_raw straight into storage. */ \
+    virtual void deserialize_raw(Deserializer &dser, size_t n) {               \
+      grow_to_fit_(num_elements_ + n);                                         \
+      for (size_t done = 0; done < n;) {                                       \
+        size_t i = num_elements_ + done, len = run_(i, n - done);              \
+        char *bytes = reinterpret_cast<char *>(&elements_[row_(i)][col_(i)]);  \
+        dser.fill_up_(bytes, len * sizeof(Stores));                            \
+        done += len;                                                           \
+      }                                                                        \
+      num_elements_ += n;                                                      \
+    }                                                                          \
+                                                                               \
     virtual void clear() { num_elements_ = 0; }                                \
                                                                                \
     virtual bool equals(Object *o) {                                           \
@@ -0,0 +1,171 @@
+// lang: CwC
+#pragma once
+#include <assert.h>
+#include <cstring>
+
+#include "object.h"
+#include "util.h"
+
+/** A growable array of booleans packed into machine words, a bit per entry.
+ * Bits past the end of the set are always kept clear so that whole words can
+ * be counted, compared and combined without masking.
+ * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
+class Bitset : public Object {
+public:
+  static const size_t WORD_BITS = sizeof(size_t) * 8;
+
+  size_t *words_ = nullptr; // owned
+  size_t size_ = 0;         // number of bits
+  size_t capacity_ = 0;     // number of words
+
+  Bitset() {}
+
+  /** Creates a bitset of n bits that are all set to value. **/
+  Bitset(size_t n, bool value) : size_(n) {
+    reserve_(words_for_(n));
+    if (value) {
+      memset(words_, 0xFF, words_for_(n) * sizeof(size_t));
+      clear_tail_();
+    }
+  }
+
+  ~Bitset() { delete[] words_; }
+
+  /** The number of words needed to hold n bits. **/
+  static size_t words_for_(size_t n) {
+    return (n + WORD_BITS - 1) / WORD_BITS;
+  }
+
+  /** Grows to at least the given number of words; new words are clear. **/
+  void reserve_(size_t words) {
+    if (words <= capacity_)
+      return;
+    size_t grown_capacity = Util::max(words, capacity_ * 2);
+    size_t *grown = new size_t[grown_capacity];
+    if (capacity_ > 0)
+      memcpy(grown, words_, capacity_ * sizeof(size_t));
+    size_t added = grown_capacity - capacity_;
+    memset(grown + capacity_, 0, added * sizeof(size_t));
+    delete[] words_;
+    words_ = grown;
+    capacity_ = grown_capacity;
+  }
+
+  /** Clears the unused bits of the last word. **/
+  void clear_tail_() {
+    if (size_ % WORD_BITS != 0)
+      words_[size_ / WORD_BITS] &= (((size_t)1) << (size_ % WORD_BITS)) - 1;
+  }
+
+  bool get(size_t i) {
+    assert(i < size_);
+    return (words_[i / WORD_BITS] >> (i % WORD_BITS)) & 1;
+  }
+
+  void set(size_t i, bool value) {
+    assert(i < size_);
+    size_t mask = ((size_t)1) << (i % WORD_BITS);
+    if (value)
+      words_[i / WORD_BITS] |= mask;
+    else
+      words_[i / WORD_BITS] &= ~mask;
+  }
+
+  void push_back(bool value) {
+    reserve_(words_for_(size_ + 1));
+    size_++;
+    set(size_ - 1, value);
+  }
+
+  size_t size() { return size_; }
+
+  void clear() {
+    if (capacity_ > 0)
+      memset(words_, 0, capacity_ * sizeof(size_t));
+    size_ = 0;
+  }
+
+  /** Counts the bits that are set. **/
+  size_t count() {
+    size_t total = 0;
+    for (size_t w = 0; w < words_for_(size_); w++) {
+      total += __builtin_popcountl(words_[w]);
+    }
+    return total;
+  }
+
+  /** Whether every bit is set, checked a word at a time. **/
+  bool all() { return count() == size_; }
+
+  /** Whether no bit is set, checked a word at a time. **/
+  bool none() {
+    for (size_t w = 0; w < words_for_(size_); w++) {
+      if (words_[w] != 0)
+        return false;
+    }
+    return true;
+  }
+
+  /** Keeps only the bits that are also set in other. Bits past the end of
+   * other are cleared. **/
+  void and_with(Bitset &other) {
+    size_t common = Util::min(words_for_(size_), words_for_(other.size_));
+    for (size_t w = 0; w < words_for_(size_); w++) {
+      words_[w] = (w < common) ? (words_[w] & other.words_[w]) : 0;
+    }
+  }
+
+  /** Sets every bit that is set in other. Bits past the end of this set are
+   * ignored. **/
+  void or_with(Bitset &other) {
+    size_t common = Util::min(words_for_(size_), words_for_(other.size_));
+    for (size_t w = 0; w < common; w++) {
+      words_[w] |= other.words_[w];
+    }
+    clear_tail_();
+  }
+
+  Bitset *clone() {
+    Bitset *copy = new Bitset(size_, false);
+    if (size_ > 0)
+      memcpy(copy->words_, words_, words_for_(size_) * sizeof(size_t));
+    return copy;
+  }
+
+  bool equals(Object *other) {
+    Bitset *that = dynamic_cast<Bitset *>(other);
+    if (that == nullptr || that->size_ != size_)
+      return false;
+    size_t bytes = words_for_(size_) * sizeof(size_t);
+    return size_ == 0 || memcmp(that->words_, words_, bytes) == 0;
+  }
+
+  /** Bitsets are mutable, so the hash is not cached. **/
+  size_t hash() {
+    size_t hash = size_;
+    for (size_t w = 0; w < words_for_(size_); w++) {
+      hash = hash * 31 + words_[w];
+    }
+    return hash;
+  }
+
+  /** Serializes the number of bits followed by the packed words. **/
+  void serialize(Serializer &ser) {
+    ser.write(size_);
+    if (size_ > 0)
+      ser.write(reinterpret_cast<char *>(words_),
+                words_for_(size_) * sizeof(size_t));
+  }
+
+  /** Replaces the contents of this bitset with one written by serialize. **/
+  Bitset *deserialize(Deserializer &dser) {
+    clear();
+    size_t len = dser.read_size_t();
+    reserve_(words_for_(len));
+    if (len > 0)
+      dser.fill_up_(reinterpret_cast<char *>(words_),
+                    words_for_(len) * sizeof(size_t));
+    size_ = len;
+    return this;
+  }
+};
@@ -0,0 +1,74 @@
+// lang: CwC
+#pragma once
+#include <assert.h>
+#include <cstring>
+
+#include "object.h"
+#include "util.h"
+
+/** A contiguous, growable block of bytes. Unlike a CharArray, which is split
+ * into chunks, a Buffer keeps all of its bytes together so they can be
+ * appended and read back with single memcpys and sent with one system call.
+ * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
+class Buffer : public Object {
+public:
+  char *data_ = nullptr; // owned
+  size_t size_ = 0;
+  size_t capacity_ = 0;
+
+  Buffer() {}
+  Buffer(size_t capacity) { reserve(capacity); }
+  Buffer(const char *bytes, size_t len) { append(bytes, len); }
+  ~Buffer() { delete[] data_; }
+
+  /** Makes room for at least capacity bytes without reallocating. **/
+  void reserve(size_t capacity) {
+    if (capacity <= capacity_)
+      return;
+    char *grown = new char[capacity];
+    if (size_ > 0)
+      memcpy(grown, data_, size_);
+    delete[] data_;
+    data_ = grown;
+    capacity_ = capacity;
+  }
+
+  /** Appends len bytes to the end of the buffer. **/
+  void append(const char *bytes, size_t len) {
+    if (size_ + len > capacity_)
+      reserve(Util::max(size_ + len, capacity_ * 2));
+    if (len > 0)
+      memcpy(data_ + size_, bytes, len);
+    size_ += len;
+  }
+
+  /** Takes ownership of a block allocated with new[] that holds len bytes,
+   * replacing the contents of this buffer. **/
+  void adopt(char *bytes, size_t len) {
+    delete[] data_;
+    data_ = bytes;
+    size_ = capacity_ = len;
+  }
+
+  void push_back(char c) { append(&c, 1); }
+
+  char get(size_t index) {
+    assert(index < size_);
+    return data_[index];
+  }
+
+  /** Gets the bytes of the buffer (owned by the buffer). **/
+  char *data() { return data_; }
+  size_t size() { return size_; }
+  void clear() { size_ = 0; }
+
+  Buffer *clone() { return new Buffer(data_, size_); }
+
+  bool equals(Object *other) {
+    Buffer *that = dynamic_cast<Buffer *>(other);
+    return that != nullptr && that->size_ == size_ &&
+           (size_ == 0 || memcmp(that->data_, data_, size_) == 0);
+  }
+
+  size_t hash_me() { return Util::hash_bytes(data_, size_); }
+};
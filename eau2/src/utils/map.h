@@ -2,149 +2,196 @@
 
 #include "array.h"
 
-// The default load for our Map implementation.
-static const float MIN_LOAD_FACTOR = 0.6;
+// The fraction of slots a Map may fill before it grows.
+static const float MAX_LOAD_FACTOR = 0.8;
 
-#define generate_classmapnode(KlassMapNode, Key, Value)                        \
-  class KlassMapNode : public Object {                                         \
-  public:                                                                      \
-    KlassMapNode *next = nullptr;                                              \
-    Key key;                                                                   \
-    Value value;                                                               \
-                                                                               \
-    KlassMapNode(Key k, Value v) : key((Key)Util::clone(k)), value(v) {}       \
-                                                                               \
-    ~KlassMapNode() {                                                          \
-      Util::destroy(key);                                                      \
-      delete next;                                                             \
-    }                                                                          \
-  }
+// The number of slots a new Map starts with, as a power of two.
+static const size_t MAP_INITIAL_BITS = 4;
 
-#define generate_classmap(KlassMap, KlassNode, KArray, VArray, K, V)           \
-  generate_classmapnode(KlassNode, K, V);                                      \
+/** Generates an open addressing hash map from K to V using Robin Hood
+ * hashing. Entries live in three parallel slot arrays (the cached hash, the
+ * key and the value) so that a probe only compares hashes until it finds a
+ * likely match. A hash of 0 marks an empty slot. Each entry is kept at most as
+ * far from its home slot as the entries it probed past, which keeps probe
+ * sequences short and lets lookups stop early. The map owns a clone of each
+ * key it stores; values are external. **/
+#define generate_classmap(KlassMap, KArray, VArray, K, V)                      \
   class KlassMap : public Object {                                             \
   public:                                                                      \
     size_t num_elements_ = 0;                                                  \
-    size_t num_nodes_ = CHUNK_SIZE;                                            \
-    KlassNode **nodes_ = nullptr;                                              \
+    size_t bits_ = MAP_INITIAL_BITS;                                           \
+    size_t capacity_ = ((size_t)1) << MAP_INITIAL_BITS;                        \
+    size_t *hashes_ = nullptr; /* owned; 0 when the slot is empty */           \
+    K *keys_ = nullptr;        /* owned, as are the keys themselves */         \
+    V *values_ = nullptr;      /* owned; the values are external */            \
                                                                                \
-    KlassMap() {                                                               \
-      nodes_ = new KlassNode *[num_nodes_];                                    \
-      for (size_t i = 0; i < num_nodes_; i++) {                                \
-        nodes_[i] = nullptr;                                                   \
-      }                                                                        \
-    }                                                                          \
+    KlassMap() { allocate_(); }                                                \
                                                                                \
     virtual ~KlassMap() {                                                      \
-      for (size_t i = 0; i < num_nodes_; i++) {                                \
-        delete nodes_[i];                                                      \
+      for (size_t i = 0; i < capacity_; i++) {                                 \
+        if (hashes_[i] != 0)                                                   \
+          Util::destroy(keys_[i]);                                             \
       }                                                                        \
-      delete[] nodes_;                                                         \
+      delete[] hashes_;                                                        \
+      delete[] keys_;                                                          \
+      delete[] values_;                                                        \
     }                                                                          \
                                                                                \
     V get(K k) {                                                               \
-      assert(contains_key(k));                                                 \
-      KlassNode *node = node_from_key_(k);                                     \
-      return node->value;                                                      \
+      size_t i = find_(k);                                                     \
+      assert(i != capacity_);                                                  \
+      return values_[i];                                                       \
     }                                                                          \
                                                                                \
+    /** Inserts or updates k with a single probe sequence. **/                 \
     void put(K k, V v) {                                                       \
-      if (contains_key(k)) {                                                   \
-        KlassNode *kn = node_from_key_(k);                                     \
-        kn->value = v;                                                         \
-      } else {                                                                 \
-        size_t i = Util::hash(k) % num_nodes_;                                 \
-        KlassNode *to_insert = new KlassNode(k, v);                            \
-        to_insert->next = nodes_[i];                                           \
-        nodes_[i] = to_insert;                                                 \
-        num_elements_++;                                                       \
-        check_load_factor_();                                                  \
+      if (num_elements_ + 1 > MAX_LOAD_FACTOR * capacity_)                     \
+        rehash_(bits_ + 1);                                                    \
+      size_t h = hash_of_(k);                                                  \
+      size_t i = home_(h), dist = 0;                                           \
+      while (hashes_[i] != 0 && distance_(i) >= dist) {                        \
+        if (hashes_[i] == h && Util::equals(keys_[i], k)) {                    \
+          values_[i] = v;                                                      \
+          return;                                                              \
+        }                                                                      \
+        i = (i + 1) & (capacity_ - 1);                                         \
+        dist++;                                                                \
       }                                                                        \
+      place_(h, (K)Util::clone(k), v, i, dist);                                \
+      num_elements_++;                                                         \
     }                                                                          \
                                                                                \
-    bool contains_key(K k) { return node_from_key_(k) != nullptr; }            \
+    bool contains_key(K k) { return find_(k) != capacity_; }                   \
                                                                                \
+    /** Removes k, shifting the entries after it back towards their homes     \
+     * rather than leaving a tombstone. **/                                    \
     V remove(K k) {                                                            \
-      assert(contains_key(k));                                                 \
-      size_t i = (Util::hash(k) % num_nodes_);                                 \
-      KlassNode *prev = nullptr, *cur = nodes_[i];                             \
-      while (cur != nullptr && !Util::equals(k, cur->key)) {                   \
-        prev = cur;                                                            \
-        cur = cur->next;                                                       \
-      }                                                                        \
-      V ret = cur->value;                                                      \
-      if (prev == nullptr) {                                                   \
-        nodes_[i] = cur->next;                                                 \
-      } else {                                                                 \
-        prev->next = cur->next;                                                \
+      size_t i = find_(k);                                                     \
+      assert(i != capacity_);                                                  \
+      V ret = values_[i];                                                      \
+      Util::destroy(keys_[i]);                                                 \
+      size_t next = (i + 1) & (capacity_ - 1);                                 \
+      while (hashes_[next] != 0 && distance_(next) > 0) {                      \
+        hashes_[i] = hashes_[next];                                            \
+        keys_[i] = keys_[next];                                                \
+        values_[i] = values_[next];                                            \
+        i = next;                                                              \
+        next = (next + 1) & (capacity_ - 1);                                   \
       }                                                                        \
-      cur->next = nullptr;                                                     \
-      delete cur;                                                              \
+      hashes_[i] = 0;                                                          \
       num_elements_--;                                                         \
       return ret;                                                              \
     }                                                                          \
                                                                                \
     KArray *keys() {                                                           \
       KArray *ka = new KArray();                                               \
-      for (size_t i = 0; i < num_nodes_; i++) {                                \
-        for (KlassNode *cur = nodes_[i]; cur != nullptr; cur = cur->next) {    \
-          ka->push_back(cur->key);                                             \
-        }                                                                      \
+      for (size_t i = 0; i < capacity_; i++) {                                 \
+        if (hashes_[i] != 0)                                                   \
+          ka->push_back(keys_[i]);                                             \
       }                                                                        \
       return ka;                                                               \
     }                                                                          \
                                                                                \
     VArray *values() {                                                         \
       VArray *va = new VArray();                                               \
-      for (size_t i = 0; i < num_nodes_; i++) {                                \
-        for (KlassNode *cur = nodes_[i]; cur != nullptr; cur = cur->next) {    \
-          va->push_back(cur->value);                                           \
-        }                                                                      \
+      for (size_t i = 0; i < capacity_; i++) {                                 \
+        if (hashes_[i] != 0)                                                   \
+          va->push_back(values_[i]);                                           \
       }                                                                        \
       return va;                                                               \
     }                                                                          \
                                                                                \
     size_t size() { return num_elements_; }                                    \
                                                                                \
-    KlassNode *node_from_key_(K k) {                                           \
-      size_t i = Util::hash(k) % num_nodes_;                                   \
-      KlassNode *node = nodes_[i];                                             \
-      while (node != nullptr && !Util::equals(node->key, k)) {                 \
-        node = node->next;                                                     \
-      }                                                                        \
-      return node;                                                             \
+    /** The hash of k as stored in a slot, which is never 0. **/              \
+    static size_t hash_of_(K k) {                                              \
+      size_t h = Util::hash(k);                                                \
+      return (h == 0) ? 1 : h;                                                 \
+    }                                                                          \
+                                                                               \
+    /** The slot an entry with the given hash would ideally occupy. The hash  \
+     * is mixed so that keys with similar hashes spread out. **/               \
+    size_t home_(size_t h) {                                                   \
+      return (h * 0xC2B2AE3D27D4EB4FULL) >> (sizeof(size_t) * 8 - bits_);      \
+    }                                                                          \
+                                                                               \
+    /** How far the entry in slot i is from its home slot. **/                 \
+    size_t distance_(size_t i) {                                               \
+      return (i - home_(hashes_[i])) & (capacity_ - 1);                        \
     }                                                                          \
                                                                                \
-    void check_load_factor_() {                                                \
-      if (num_elements_ > MIN_LOAD_FACTOR * num_nodes_) {                      \
-        rehash_(num_nodes_ * 2);                                               \
+    /** The slot holding k, or capacity_ if k is absent. **/                   \
+    size_t find_(K k) {                                                        \
+      size_t h = hash_of_(k);                                                  \
+      size_t i = home_(h), dist = 0;                                           \
+      while (hashes_[i] != 0 && distance_(i) >= dist) {                        \
+        if (hashes_[i] == h && Util::equals(keys_[i], k))                      \
+          return i;                                                            \
+        i = (i + 1) & (capacity_ - 1);                                         \
+        dist++;                                                                \
       }                                                                        \
+      return capacity_;                                                        \
     }                                                                          \
                                                                                \
-    void rehash_(size_t new_num_nodes) {                                       \
-      KlassNode **old_nodes = nodes_;                                          \
-      size_t old_num_nodes = num_nodes_;                                       \
-      nodes_ = new KlassNode *[new_num_nodes];                                 \
-      for (size_t i = 0; i < new_num_nodes; i++) {                             \
-        nodes_[i] = nullptr;                                                   \
+    /** Puts an entry into slot i, which is dist away from its home. Any      \
+     * entry there that is closer to its own home is carried forward. **/     \
+    void place_(size_t h, K k, V v, size_t i, size_t dist) {                   \
+      while (hashes_[i] != 0) {                                                \
+        size_t d = distance_(i);                                               \
+        if (d < dist) {                                                        \
+          size_t hold_h = hashes_[i];                                          \
+          K hold_k = keys_[i];                                                 \
+          V hold_v = values_[i];                                               \
+          hashes_[i] = h;                                                      \
+          keys_[i] = k;                                                        \
+          values_[i] = v;                                                      \
+          h = hold_h;                                                          \
+          k = hold_k;                                                          \
+          v = hold_v;                                                          \
+          dist = d;                                                            \
+        }                                                                      \
+        i = (i + 1) & (capacity_ - 1);                                         \
+        dist++;                                                                \
       }                                                                        \
-      num_nodes_ = new_num_nodes;                                              \
-      num_elements_ = 0;                                                       \
-      for (size_t i = 0; i < old_num_nodes; i++) {                             \
-        for (KlassNode *cur = old_nodes[i]; cur != nullptr; cur = cur->next) { \
-          put(cur->key, cur->value);                                           \
+      hashes_[i] = h;                                                          \
+      keys_[i] = k;                                                            \
+      values_[i] = v;                                                          \
+    }                                                                          \
+                                                                               \
+    void allocate_() {                                                         \
+      hashes_ = new size_t[capacity_];                                         \
+      memset(hashes_, 0, capacity_ * sizeof(size_t));                          \
+      keys_ = new K[capacity_];                                                \
+      values_ = new V[capacity_];                                              \
+    }                                                                          \
+                                                                               \
+    /** Grows to 2^new_bits slots, moving the existing keys and their cached  \
+     * hashes rather than cloning or rehashing them. **/                       \
+    void rehash_(size_t new_bits) {                                            \
+      size_t *old_hashes = hashes_;                                            \
+      K *old_keys = keys_;                                                     \
+      V *old_values = values_;                                                 \
+      size_t old_capacity = capacity_;                                         \
+      bits_ = new_bits;                                                        \
+      capacity_ = ((size_t)1) << new_bits;                                     \
+      allocate_();                                                             \
+      for (size_t i = 0; i < old_capacity; i++) {                              \
+        if (old_hashes[i] != 0) {                                              \
+          size_t h = old_hashes[i];                                            \
+          place_(h, old_keys[i], old_values[i], home_(h), 0);                  \
         }                                                                      \
-        delete old_nodes[i];                                                   \
       }                                                                        \
-      delete[] old_nodes;                                                      \
+      delete[] old_hashes;                                                     \
+      delete[] old_keys;                                                       \
+      delete[] old_values;                                                     \
     }                                                                          \
   }
 
 /** Generates a Mapping from Object to Object **/
-generate_classmap(Map, MapNode, Array, Array, Object *, Object *);
+generate_classmap(Map, Array, Array, Object *, Object *);
 
 /** Represents a Mapping from String* to int **/
-generate_classmap(SIMap, SINode, StringArray, IntArray, String *, int);
+generate_classmap(SIMap, StringArray, IntArray, String *, int);
 
 #define generate_object_classmap(KlassMap, KlassArray, Klass)                  \
   class KlassMap : public Map {                                                \
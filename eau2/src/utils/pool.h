@@ -0,0 +1,206 @@
+#pragma once
+// lang: CwC
+#include "thread.h"
+#include "util.h"
+
+/** The body of a parallel loop over a number of morsels. Each morsel is run
+ * exactly once, on one of the pool's slots; a slot never runs two morsels at
+ * the same time, so per slot state needs no locking.
+ * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
+class ParallelTask : public Object {
+public:
+  /** Runs morsel m as slot, which is less than the pool's slots(). **/
+  virtual void run(size_t m, size_t slot) = 0;
+};
+
+/** The morsels a slot has yet to run, as a range. The owner takes morsels
+ * from the front; a thief takes the back half.
+ * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
+class MorselRange : public Object {
+public:
+  Lock lock_;
+  size_t begin_ = 0, end_ = 0;
+
+  /** Replaces the range with [begin, end). **/
+  void reset(size_t begin, size_t end) {
+    lock_.lock();
+    begin_ = begin;
+    end_ = end;
+    lock_.unlock();
+  }
+
+  /** Takes the next morsel into m, returning false if there is none. **/
+  bool take(size_t &m) {
+    lock_.lock();
+    bool found = begin_ < end_;
+    if (found)
+      m = begin_++;
+    lock_.unlock();
+    return found;
+  }
+
+  /** Moves the back half of this range, rounded up, into thief, which must
+   * be empty. Returns false if there was nothing to steal. **/
+  bool steal_into(MorselRange &thief) {
+    lock_.lock();
+    size_t left = end_ - begin_;
+    size_t split = end_ - (left + 1) / 2;
+    size_t end = end_;
+    end_ = split;
+    lock_.unlock();
+    if (left == 0)
+      return false;
+    thief.reset(split, end);
+    return true;
+  }
+};
+
+class ThreadPool;
+
+/** A background thread of a pool, which runs as one of its slots.
+ * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
+class PoolWorker : public Thread {
+public:
+  ThreadPool *pool_; // external
+  size_t slot_;
+
+  PoolWorker(ThreadPool *pool, size_t slot) : pool_(pool), slot_(slot) {}
+
+  void run();
+};
+
+/** A persistent set of worker threads that run parallel loops. A loop's
+ * morsels are split evenly between the slots, and a slot that runs out steals
+ * half of what another slot has left, so one slow morsel does not hold up the
+ * rest of the loop. The calling thread runs as slot 0, so a pool of n slots
+ * has n - 1 threads. One loop runs at a time; a loop started from inside
+ * another runs inline on the current slot.
+ * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
+class ThreadPool : public Object {
+public:
+  size_t slots_;
+  MorselRange *ranges_;          // owned; one per slot
+  PoolWorker **workers_;         // owned; slots 1 and up
+  Lock loop_lock_;               // held for the whole of a loop
+  Lock lock_;                    // guards the fields below
+  ParallelTask *task_ = nullptr; // external; the running loop
+  size_t generation_ = 0;        // counts the loops started
+  size_t active_ = 0;            // workers inside the running loop
+  bool stop_ = false;
+
+  /** The slot the current thread runs as, or -1 outside of a loop. **/
+  static size_t &current_slot_() {
+    static thread_local size_t slot = -1;
+    return slot;
+  }
+
+  /** Creates a pool of the given number of slots, at least one. **/
+  ThreadPool(size_t slots) : slots_(Util::max(slots, (size_t)1)) {
+    ranges_ = new MorselRange[slots_];
+    workers_ = new PoolWorker *[slots_];
+    workers_[0] = nullptr;
+    for (size_t i = 1; i < slots_; i++) {
+      workers_[i] = new PoolWorker(this, i);
+      workers_[i]->start();
+    }
+  }
+
+  ~ThreadPool() {
+    lock_.lock();
+    stop_ = true;
+    lock_.notify_all();
+    lock_.unlock();
+    for (size_t i = 1; i < slots_; i++) {
+      workers_[i]->join();
+      delete workers_[i];
+    }
+    delete[] workers_;
+    delete[] ranges_;
+  }
+
+  /** The pool shared by the whole process, with a slot per hardware
+   * thread. **/
+  static ThreadPool &instance() {
+    static ThreadPool pool(std::thread::hardware_concurrency());
+    return pool;
+  }
+
+  size_t slots() { return slots_; }
+
+  /** Runs morsels 0 to n - 1 of the task across the pool and returns once
+   * all of them have finished. **/
+  void parallel_for(ParallelTask &task, size_t n) {
+    size_t &slot = current_slot_();
+    if (slot != (size_t)-1 || slots_ == 1 || n <= 1) {
+      size_t inline_slot = (slot == (size_t)-1) ? 0 : slot;
+      for (size_t m = 0; m < n; m++)
+        task.run(m, inline_slot);
+      return;
+    }
+    loop_lock_.lock();
+    for (size_t i = 0; i < slots_; i++)
+      ranges_[i].reset(n * i / slots_, n * (i + 1) / slots_);
+    lock_.lock();
+    task_ = &task;
+    generation_++;
+    lock_.notify_all();
+    lock_.unlock();
+
+    slot = 0;
+    work_(task, 0);
+    slot = -1;
+
+    lock_.lock();
+    while (active_ > 0)
+      lock_.wait();
+    task_ = nullptr;
+    lock_.unlock();
+    loop_lock_.unlock();
+  }
+
+  /** Runs morsels as the given slot until there are none left anywhere. **/
+  void work_(ParallelTask &task, size_t slot) {
+    size_t m;
+    while (true) {
+      while (ranges_[slot].take(m))
+        task.run(m, slot);
+      if (!steal_(slot))
+        return;
+    }
+  }
+
+  /** Refills a slot's empty range from the others, starting with its
+   * neighbour. Returns false once every range is empty. **/
+  bool steal_(size_t slot) {
+    for (size_t i = 1; i < slots_; i++) {
+      if (ranges_[(slot + i) % slots_].steal_into(ranges_[slot]))
+        return true;
+    }
+    return false;
+  }
+
+  /** The loop of a background slot: wait for a loop to start, help run it,
+   * repeat. **/
+  void serve_(size_t slot) {
+    current_slot_() = slot;
+    size_t seen = 0;
+    lock_.lock();
+    while (true) {
+      while (!stop_ && (generation_ == seen || task_ == nullptr))
+        lock_.wait();
+      if (stop_)
+        break;
+      seen = generation_;
+      ParallelTask *task = task_;
+      active_++;
+      lock_.unlock();
+      work_(*task, slot);
+      lock_.lock();
+      if (--active_ == 0)
+        lock_.notify_all();
+    }
+    lock_.unlock();
+  }
+};
+
+void PoolWorker::run() { pool_->serve_(slot_); }
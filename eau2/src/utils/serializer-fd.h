@@ -4,19 +4,22 @@
 // Forward declaration of Object
 class Object;
 
-// Forward declaration of CharArray
-class CharArray;
+// Forward declaration of Buffer
+class Buffer;
 
 /** Represents a Serializer that can take a Message and
- * serialize its contents.
+ * serialize its contents into one contiguous buffer.
  * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
 class Serializer {
 public:
-  CharArray *data_;
+  Buffer *data_;
 
   Serializer();
   ~Serializer();
 
+  /** Makes room for at least len more bytes. **/
+  void reserve(size_t len);
+
   /** Write methods **/
   void write(Object *o);
   void write(size_t x);
@@ -30,20 +33,22 @@ public:
   /** Informational methods **/
   size_t num_chunks();
   char *get_chunk(size_t index);
-  CharArray *data();
+  Buffer *data();
   size_t length();
-  CharArray *steal();
+  Buffer *steal();
 };
 
 /** Represents a Deserializer that can read from serialized data.
  * @author griep.p@husky.neu.edu & colabella.a@husky.neu.edu **/
 class Deserializer {
 public:
-  CharArray *data_;
+  Buffer *data_;
   size_t cursor_ = 0;
+  bool owns_; // whether the data is deleted with the deserializer
 
-  Deserializer(CharArray *data);
-  Deserializer(CharArray &data);
+  /** Reads from owned data, or borrows data that must outlive it. **/
+  Deserializer(Buffer *data);
+  Deserializer(Buffer &data);
   ~Deserializer();
 
   /** Peek at the first value **/
@@ -56,9 +61,10 @@ public:
   int read_int();
   float read_float();
   double read_double();
+  Buffer *read_buffer(size_t len);
 
   size_t incr_cursor_();
   char next_char_();
   void fill_up_(char *bytes, size_t len);
-  CharArray *data() { return data_; }
+  Buffer *data() { return data_; }
 };
@@ -2,29 +2,27 @@
 #pragma once
 
 #include "array.h"
+#include "buffer.h"
 #include "serializer-fd.h"
 
 /** Serializer constructor/destructor **/
-Serializer::Serializer() { data_ = new CharArray(); }
+Serializer::Serializer() { data_ = new Buffer(); }
 Serializer::~Serializer() { delete data_; }
 
+/** Makes room for at least len more bytes **/
+void Serializer::reserve(size_t len) { data_->reserve(data_->size() + len); }
+
 /** Writes an Object to this serializer **/
 void Serializer::write(Object *o) { o->serialize(*this); }
 
 /** Writes a size_t to this serializer **/
 void Serializer::write(size_t v) {
-  char *cv = reinterpret_cast<char *>(&v);
-  for (size_t i = 0; i < sizeof(size_t); i++) {
-    data_->push_back(cv[i]);
-  }
+  data_->append(reinterpret_cast<char *>(&v), sizeof(size_t));
 }
 
 /** Writes an integer to this serializer **/
 void Serializer::write(int v) {
-  char *cv = reinterpret_cast<char *>(&v);
-  for (size_t i = 0; i < sizeof(int); i++) {
-    data_->push_back(cv[i]);
-  }
+  data_->append(reinterpret_cast<char *>(&v), sizeof(int));
 }
 
 /** Writes a char to this serializer **/
@@ -32,65 +30,55 @@ void Serializer::write(char c) { data_->push_back(c); }
 
 /** Writes a boolean to this serializer **/
 void Serializer::write(bool b) {
-  char *cv = reinterpret_cast<char *>(&b);
-  for (size_t i = 0; i < sizeof(bool); i++) {
-    data_->push_back(cv[i]);
-  }
+  data_->append(reinterpret_cast<char *>(&b), sizeof(bool));
 }
 
 /** Writes a float to this serializer **/
 void Serializer::write(float f) {
-  char *cv = reinterpret_cast<char *>(&f);
-  for (size_t i = 0; i < sizeof(float); i++) {
-    data_->push_back(cv[i]);
-  }
+  data_->append(reinterpret_cast<char *>(&f), sizeof(float));
 }
 
 /** Writes a double to this serializer **/
 void Serializer::write(double d) {
-  char *cv = reinterpret_cast<char *>(&d);
-  for (size_t i = 0; i < sizeof(double); i++) {
-    data_->push_back(cv[i]);
-  }
+  data_->append(reinterpret_cast<char *>(&d), sizeof(double));
 }
 
 /** Writes a character array to this serializer **/
-void Serializer::write(char *arr, size_t len) {
-  for (size_t i = 0; i < len; i++)
-    data_->push_back(arr[i]);
-}
+void Serializer::write(char *arr, size_t len) { data_->append(arr, len); }
 
 /** Gets the data (read-only) **/
-CharArray *Serializer::data() { return data_; }
+Buffer *Serializer::data() { return data_; }
 size_t Serializer::length() { return data_->size(); }
 
 /** Steals data from the serializer **/
-CharArray *Serializer::steal() {
-  CharArray *data = data_;
+Buffer *Serializer::steal() {
+  Buffer *data = data_;
   data_ = nullptr;
   return data;
 }
 
-/** Gets the internal details and chunks of the serializer.
- * (Warning) this uses field-of-field and is poorly designed. **/
-size_t Serializer::num_chunks() { return data_->num_chunks_; }
-char *Serializer::get_chunk(size_t index) { return data_->elements_[index]; }
+/** The serialized data is a single contiguous chunk. **/
+size_t Serializer::num_chunks() { return (data_->size() > 0) ? 1 : 0; }
+char *Serializer::get_chunk(size_t index) {
+  assert(index < num_chunks());
+  return data_->data();
+}
 
 /** Deserializer implementation **/
 
 /** Constructors and deconstructors **/
-Deserializer::Deserializer(CharArray *data) { data_ = data; }
-Deserializer::Deserializer(CharArray &data) { data_ = data.clone(); }
-Deserializer::~Deserializer() { delete data_; }
+Deserializer::Deserializer(Buffer *data) : data_(data), owns_(true) {}
+Deserializer::Deserializer(Buffer &data) : data_(&data), owns_(false) {}
+Deserializer::~Deserializer() {
+  if (owns_)
+    delete data_;
+}
 
 /** Peek at the first value **/
 size_t Deserializer::peek_size_t() {
   assert(sizeof(size_t) + cursor_ <= data_->size());
   size_t v;
-  char *cv = reinterpret_cast<char *>(&v);
-  for (size_t i = 0; i < sizeof(size_t) && cursor_ + i < data_->size(); i++) {
-    cv[i] = data_->get(cursor_ + i);
-  }
+  memcpy(&v, data_->data() + cursor_, sizeof(size_t));
   return v;
 }
 
@@ -139,6 +127,14 @@ double Deserializer::read_double() {
   return v;
 }
 
+/** Read len bytes into a new buffer **/
+Buffer *Deserializer::read_buffer(size_t len) {
+  assert(cursor_ + len <= data_->size());
+  Buffer *buf = new Buffer(data_->data() + cursor_, len);
+  cursor_ += len;
+  return buf;
+}
+
 /** Safely increments the cursor **/
 size_t Deserializer::incr_cursor_() {
   assert(cursor_ < data_->size());
@@ -150,7 +146,7 @@ char Deserializer::next_char_() { return data_->get(incr_cursor_()); }
 
 /** Fills up the given buffer. **/
 void Deserializer::fill_up_(char *bytes, size_t len) {
-  for (size_t i = 0; i < len; i++) {
-    bytes[i] = next_char_();
-  }
-}
\ No newline at end of file
+  assert(cursor_ + len <= data_->size());
+  memcpy(bytes, data_->data() + cursor_, len);
+  cursor_ += len;
+}
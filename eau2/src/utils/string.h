@@ -1,6 +1,7 @@
 #pragma once
 // LANGUAGE: CwC
 #include "object.h"
+#include "util.h"
 #include <cassert>
 #include <cstring>
 #include <string>
@@ -13,16 +14,19 @@
  *  author: vitekj@me.com */
 class String : public Object {
 public:
-  size_t size_; // number of characters excluding terminate (\0)
-  char *cstr_;  // owned; char array
+  /** Strings up to this long are kept inside the String itself. */
+  static const size_t INLINE_CAPACITY = 22;
+
+  size_t size_;       // number of characters excluding terminate (\0)
+  char *cstr_;        // owned unless a view or inline_; char array
+  bool owned_ = true; // whether cstr_ belongs to the string
+  char inline_[INLINE_CAPACITY + 1]; // holds short strings without a new[]
+
+  /** Builds an empty view; point it at characters with view(). */
+  String() : size_(0), cstr_(nullptr), owned_(false) {}
 
   /** Build a string from a string constant */
-  String(char const *cstr, size_t len) {
-    size_ = len;
-    cstr_ = new char[size_ + 1];
-    memcpy(cstr_, cstr, size_ + 1);
-    cstr_[size_] = 0; // terminate
-  }
+  String(char const *cstr, size_t len) { copy_(cstr, len); }
   /** Builds a string from a char*, steal must be true, we do not copy!
    *  cstr must be allocated for len+1 and must be zero terminated. */
   String(bool steal, char *cstr, size_t len) {
@@ -34,14 +38,30 @@ public:
   String(char const *cstr) : String(cstr, strlen(cstr)) {}
 
   /** Build a string from another String */
-  String(String &from) : Object(from) {
-    size_ = from.size_;
-    cstr_ = new char[size_ + 1]; // ensure that we copy the terminator
-    memcpy(cstr_, from.cstr_, size_ + 1);
-  }
+  String(String &from) : Object(from) { copy_(from.cstr_, from.size_); }
 
   /** Delete the string */
-  ~String() { delete[] cstr_; }
+  ~String() {
+    if (owned_ && cstr_ != inline_)
+      delete[] cstr_;
+  }
+
+  /** Copies len characters into inline_ if they fit, or onto the heap. */
+  void copy_(char const *cstr, size_t len) {
+    size_ = len;
+    cstr_ = (len <= INLINE_CAPACITY) ? inline_ : new char[len + 1];
+    memcpy(cstr_, cstr, len);
+    cstr_[size_] = 0; // terminate
+  }
+
+  /** Points a view at len characters of cstr without copying them. cstr
+   * must be zero terminated and outlive the view. */
+  void view(char *cstr, size_t len) {
+    assert(!owned_);
+    cstr_ = cstr;
+    size_ = len;
+    hash_ = 0;
+  }
 
   /** Return the number characters in the string (does not count the terminator)
    */
@@ -65,26 +85,30 @@ public:
       return false;
     if (size_ != x->size_)
       return false;
-    return strncmp(cstr_, x->cstr_, size_) == 0;
+    if (hash_ != 0 && x->hash_ != 0 && hash_ != x->hash_)
+      return false; // both hashes are cached and differ
+    return memcmp(cstr_, x->cstr_, size_) == 0;
   }
 
   /** Deep copy of this string */
   String *clone() { return new String(*this); }
 
-  /** This consumes cstr_, the String must be deleted next */
+  /** This consumes cstr_, the String must be deleted next. A view or an
+   * inline string hands out a heap copy, since it cannot give its characters
+   * away. */
   char *steal() {
     char *res = cstr_;
+    if (!owned_ || cstr_ == inline_) {
+      res = new char[size_ + 1];
+      memcpy(res, cstr_, size_ + 1);
+    }
     cstr_ = nullptr;
     return res;
   }
 
-  /** Compute a hash for this string. */
-  size_t hash_me() {
-    size_t hash = 0;
-    for (size_t i = 0; i < size_; ++i)
-      hash = cstr_[i] + (hash << 6) + (hash << 16) - hash;
-    return hash;
-  }
+  /** Compute a hash for this string. Strings are immutable, so hash() only
+   * calls this once and caches the result. */
+  size_t hash_me() { return Util::hash_bytes(cstr_, size_); }
 
   /** Serializes a string **/
   void serialize(Serializer &ser) {
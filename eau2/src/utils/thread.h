@@ -6,6 +6,7 @@
 #include <condition_variable>
 #include <cstdlib>
 #include <mutex>
+#include <pthread.h>
 #include <sstream>
 #include <thread>
 
@@ -70,4 +71,22 @@ public:
 
   // Notify all threads waiting on this lock
   void notify_all() { cv_.notify_all(); }
-};
\ No newline at end of file
+};
+
+/** A lock that can be held by many readers at once or by a single writer. */
+class ReadWriteLock : public Object {
+public:
+  pthread_rwlock_t rwlock_;
+
+  ReadWriteLock() { pthread_rwlock_init(&rwlock_, nullptr); }
+  ~ReadWriteLock() { pthread_rwlock_destroy(&rwlock_); }
+
+  /** Acquire shared ownership, blocking while a writer holds the lock. */
+  void read_lock() { pthread_rwlock_rdlock(&rwlock_); }
+
+  /** Acquire exclusive ownership, blocking while anyone holds the lock. */
+  void write_lock() { pthread_rwlock_wrlock(&rwlock_); }
+
+  /** Release whichever ownership the current thread holds. */
+  void unlock() { pthread_rwlock_unlock(&rwlock_); }
+};
@@ -2,6 +2,7 @@
 // lang:CwC
 
 #include "object.h"
+#include <cstring>
 
 static const double DOUBLE_TOLERANCE = 0.0001;
 
@@ -36,6 +37,30 @@ public:
   static size_t hash(bool a) { return a; }
   static size_t hash(size_t a) { return a; }
 
+  /** Hashes len bytes a word at a time, folding each word in with a
+   * multiply. Never returns 0, so the result can be cached in Object::hash_.
+   * Assumes a 64 bit size_t. **/
+  static size_t hash_bytes(const char *bytes, size_t len) {
+    const size_t SEED = 0xa0761d6478bd642fULL, PRIME = 0xe7037ed1a0b428dbULL;
+    size_t h = len ^ SEED;
+    size_t i = 0;
+    for (; i + sizeof(size_t) <= len; i += sizeof(size_t)) {
+      size_t word;
+      memcpy(&word, bytes + i, sizeof(size_t));
+      h = mix_(h ^ word, PRIME);
+    }
+    size_t tail = 0;
+    memcpy(&tail, bytes + i, len - i);
+    h = mix_(mix_(h ^ tail, PRIME), SEED);
+    return (h == 0) ? 1 : h;
+  }
+
+  /** Multiplies a by b and folds the high bits back into the low ones. **/
+  static size_t mix_(size_t a, size_t b) {
+    size_t product = a * b;
+    return product ^ (product >> 32);
+  }
+
   /** Clone functions **/
   static Object *clone(Object *a) { return (a == nullptr) ? a : a->clone(); }
   static int clone(int a) { return a; }
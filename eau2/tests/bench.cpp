@@ -0,0 +1,89 @@
+// lang: CwC
+// Times the bulk column encodings against writing a column one element at a
+// time. Not part of the test suite; build and run it with `make bench`.
+
+#include "../src/store/column.h"
+#include "../src/utils/serializer.h"
+#include <chrono>
+
+static const size_t ROUNDS = 50;
+
+/** Microseconds since an arbitrary point. **/
+static long now() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/** The per-element encoding that the bulk encoding replaced. **/
+static void serialize_elementwise(Serializer &ser, IntColumn &c) {
+  ser.write(c.get_type());
+  ser.write(c.size());
+  for (size_t i = 0; i < c.size(); i++)
+    ser.write(c.is_missing(i));
+  for (size_t i = 0; i < c.size(); i++)
+    if (!c.is_missing(i))
+      ser.write(c.get(i));
+}
+
+/** The per-element decoding that the bulk decoding replaced. **/
+static IntColumn *deserialize_elementwise(Deserializer &dser) {
+  IntColumn *c = new IntColumn();
+  dser.read_char();
+  size_t len = dser.read_size_t();
+  BoolArray missing;
+  for (size_t i = 0; i < len; i++)
+    missing.push_back(dser.read_bool());
+  for (size_t i = 0; i < len; i++) {
+    if (missing.get(i))
+      c->push_back_missing();
+    else
+      c->push_back(dser.read_int());
+  }
+  return c;
+}
+
+int main() {
+  IntColumn ic;
+  FloatColumn fc;
+  for (size_t i = 0; i < CHUNK_SIZE; i++) {
+    if (i % 10 == 0) {
+      ic.push_back_missing();
+      fc.push_back_missing();
+    } else {
+      ic.push_back((int)i);
+      fc.push_back((float)i / 2);
+    }
+  }
+
+  long start = now();
+  for (size_t r = 0; r < ROUNDS; r++) {
+    Serializer ser;
+    serialize_elementwise(ser, ic);
+    Deserializer dser(*ser.data());
+    delete deserialize_elementwise(dser);
+  }
+  long elementwise = now() - start;
+
+  start = now();
+  for (size_t r = 0; r < ROUNDS; r++) {
+    Serializer ser;
+    ser.write(&ic);
+    Deserializer dser(*ser.data());
+    delete Column::deserialize(dser);
+  }
+  long bulk = now() - start;
+  printf("IntColumn round trip of %zu rows: %ldus elementwise, %ldus bulk\n",
+         CHUNK_SIZE, elementwise / ROUNDS, bulk / ROUNDS);
+
+  start = now();
+  for (size_t r = 0; r < ROUNDS; r++) {
+    Serializer ser;
+    ser.write(&fc);
+    Deserializer dser(*ser.data());
+    delete Column::deserialize(dser);
+  }
+  printf("FloatColumn round trip of %zu rows: %ldus\n", CHUNK_SIZE,
+         (now() - start) / ROUNDS);
+  return 0;
+}
@@ -0,0 +1,79 @@
+// lang: CwC
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include "../src/utils/bitset.h"
+#include "../src/utils/serializer.h"
+#include "test-macros.h"
+
+/**
+ * @brief Here's are the unit tests for the Bitset class.
+ */
+class BitsetTest : public ::testing::Test {
+public:
+  Bitset b;
+
+  /** Fills the bitset with every third bit set, across several words. **/
+  void SetUp() {
+    for (size_t i = 0; i < 200; i++) {
+      b.push_back(i % 3 == 0);
+    }
+  }
+};
+
+TEST_F(BitsetTest, PushGetSet) {
+  ASSERT_EQ(b.size(), 200);
+  for (size_t i = 0; i < b.size(); i++) {
+    ASSERT_EQ(b.get(i), i % 3 == 0);
+  }
+  b.set(1, true);
+  b.set(0, false);
+  ASSERT(b.get(1));
+  ASSERT(!b.get(0));
+}
+
+TEST_F(BitsetTest, CountAllNone) {
+  ASSERT_EQ(b.count(), 67);
+  ASSERT(!b.all());
+  ASSERT(!b.none());
+
+  Bitset full(130, true);
+  ASSERT(full.all());
+  ASSERT_EQ(full.count(), 130);
+
+  Bitset empty(130, false);
+  ASSERT(empty.none());
+  ASSERT_EQ(empty.count(), 0);
+}
+
+TEST_F(BitsetTest, AndOr) {
+  Bitset evens;
+  for (size_t i = 0; i < 200; i++) {
+    evens.push_back(i % 2 == 0);
+  }
+
+  Bitset *both = b.clone();
+  both->and_with(evens);
+  for (size_t i = 0; i < 200; i++) {
+    ASSERT_EQ(both->get(i), i % 6 == 0);
+  }
+
+  Bitset *either = b.clone();
+  either->or_with(evens);
+  for (size_t i = 0; i < 200; i++) {
+    ASSERT_EQ(either->get(i), i % 2 == 0 || i % 3 == 0);
+  }
+  delete both;
+  delete either;
+}
+
+TEST_F(BitsetTest, Serialize) {
+  Serializer ser;
+  ser.write(&b);
+  Deserializer dser(*ser.data());
+  Bitset copy;
+  copy.deserialize(dser);
+  ASSERT(b.equals(&copy));
+  ASSERT_EQ(b.hash(), copy.hash());
+}
@@ -0,0 +1,58 @@
+// lang: CwC
+#pragma once
+
+#include "../src/store/column.h"
+#include "../src/utils/serializer.h"
+#include "test-macros.h"
+#include <gtest/gtest.h>
+
+/**
+ * @brief Checks that the bulk column encodings round trip a full chunk,
+ * missing values included. Their speed is measured by tests/bench.cpp.
+ * @author griep.p@husky.neu.edu, colabella.a@husky.neu.edu
+ */
+class BulkColumnTest : public ::testing::Test {
+public:
+  IntColumn ic;
+  FloatColumn fc;
+
+  void SetUp() {
+    for (size_t i = 0; i < CHUNK_SIZE; i++) {
+      if (i % 10 == 0) {
+        ic.push_back_missing();
+        fc.push_back_missing();
+      } else {
+        ic.push_back((int)i);
+        fc.push_back((float)i / 2);
+      }
+    }
+  }
+};
+
+TEST_F(BulkColumnTest, IntColumnRoundTrip) {
+  Serializer ser;
+  ser.write(&ic);
+  Deserializer dser(*ser.data());
+  IntColumn *copy = Column::deserialize(dser)->as_int();
+
+  ASSERT_EQ(copy->size(), ic.size());
+  for (size_t i = 0; i < ic.size(); i++) {
+    ASSERT_EQ(copy->is_missing(i), ic.is_missing(i));
+    ASSERT_EQ(copy->get(i), ic.get(i));
+  }
+  delete copy;
+}
+
+TEST_F(BulkColumnTest, FloatColumnRoundTrip) {
+  Serializer ser;
+  ser.write(&fc);
+  Deserializer dser(*ser.data());
+  FloatColumn *copy = Column::deserialize(dser)->as_float();
+
+  ASSERT_EQ(copy->size(), fc.size());
+  for (size_t i = 0; i < fc.size(); i++) {
+    ASSERT_EQ(copy->is_missing(i), fc.is_missing(i));
+    ASSERT_EQ(copy->get(i), fc.get(i));
+  }
+  delete copy;
+}
@@ -0,0 +1,106 @@
+// lang: CwC
+#pragma once
+
+#include "../src/store/cache.h"
+#include "test-macros.h"
+#include <gtest/gtest.h>
+
+/**
+ * @brief Tests for the node-wide cache of remote chunks.
+ * @author griep.p@husky.neu.edu, colabella.a@husky.neu.edu
+ */
+class CacheTest : public ::testing::Test {
+public:
+  Key base{"frame", 0};
+
+  /** A value holding the given number of bytes. **/
+  static Value *value_of(size_t bytes) {
+    Buffer *data = new Buffer();
+    for (size_t i = 0; i < bytes; i++)
+      data->push_back((char)i);
+    return new Value(data);
+  }
+};
+
+TEST_F(CacheTest, HitsAndMisses) {
+  ChunkCache cache(1000);
+  ChunkKey k(base, 0, 1, 1);
+  ASSERT_EQ(cache.get(&k), nullptr);
+
+  Value *v = value_of(10);
+  cache.put(&k, v);
+  Value *hit = cache.get(&k);
+  ASSERT_EQ(hit->blob(), v->blob()); // the bytes are shared, not copied
+  ASSERT_EQ(cache.hits(), 1);
+  ASSERT_EQ(cache.misses(), 1);
+  ASSERT_EQ(cache.bytes(), 10);
+  delete hit;
+  delete v;
+}
+
+TEST_F(CacheTest, InvalidateDropsEntry) {
+  ChunkCache cache(1000);
+  ChunkKey k(base, 0, 1, 1), other(base, 0, 2, 1);
+  Value *v = value_of(10);
+  cache.put(&k, v);
+  cache.invalidate(&k);
+  cache.invalidate(&other); // not cached, so nothing happens
+  ASSERT_EQ(cache.get(&k), nullptr);
+  ASSERT_EQ(cache.size(), 0);
+  ASSERT_EQ(cache.bytes(), 0);
+  delete v;
+}
+
+TEST_F(CacheTest, EvictsLeastRecentlyUsed) {
+  ChunkCache cache(30);
+  ChunkKey a(base, 0, 0, 1), b(base, 0, 1, 1), c(base, 0, 2, 1);
+  Value *v = value_of(10);
+  cache.put(&a, v);
+  cache.put(&b, v);
+  cache.put(&c, v);
+  delete cache.get(&a); // b is now the least recently used
+
+  Value *big = value_of(15);
+  cache.put(&b, big); // replaces b, evicting c to make room
+  ASSERT_EQ(cache.size(), 2);
+  ASSERT_EQ(cache.bytes(), 25);
+  ASSERT_EQ(cache.evictions(), 1);
+
+  Value *hit = cache.get(&c);
+  ASSERT_EQ(hit, nullptr);
+  hit = cache.get(&b);
+  ASSERT_EQ(hit->size(), 15);
+  delete hit;
+
+  cache.set_budget(12);
+  ASSERT_EQ(cache.size(), 0); // b was used last, so a went first
+  cache.put(&a, big);         // larger than the whole budget
+  ASSERT_EQ(cache.size(), 0);
+  delete v;
+  delete big;
+}
+
+TEST_F(CacheTest, PendingChunkHandsOverValues) {
+  KeyArray *wanted = new KeyArray();
+  KeyArray *answered = new KeyArray();
+  ValueArray *values = new ValueArray();
+  for (size_t col = 0; col < 3; col++) {
+    wanted->push_back(new ChunkKey(base, col, 4, 1));
+    answered->push_back(new ChunkKey(base, col, 4, 1));
+    values->push_back(value_of(col + 1));
+  }
+  Future *request = new Future();
+  PendingChunk pending(4, wanted, request);
+  ASSERT(!request->ready());
+
+  request->complete(new MultiReply(answered, values));
+  for (size_t col = 0; col < 3; col++) {
+    ChunkKey k(base, col, 4, 1);
+    Value *v = pending.take(&k);
+    ASSERT_EQ(v->size(), col + 1);
+    ASSERT_EQ(pending.take(&k), nullptr); // each value is handed over once
+    delete v;
+  }
+  ChunkKey other(base, 0, 5, 1);
+  ASSERT_EQ(pending.take(&other), nullptr);
+}
@@ -77,7 +77,7 @@ public:
       case 'F':
         return c1->as_float()->vals_.equals(&c2->as_float()->vals_);
       case 'S':
-        return c1->as_string()->vals_.equals(&c2->as_string()->vals_);
+        return c1->as_string()->equals(c2);
       case 'B':
         return c1->as_bool()->vals_.equals(&c2->as_bool()->vals_);
       }
@@ -198,3 +198,119 @@ TEST_F(ColumnTest, ColumnEquality) {
   delete nefc2;
   delete nesc2;
 }
+
+TEST_F(ColumnTest, DictStringColumn) {
+  DictStringColumn dc;
+  for (size_t i = 0; i < 300; i++) {
+    if (i % 50 == 0)
+      dc.push_back_missing();
+    else
+      dc.push_back((i % 3 == 0) ? a : (i % 3 == 1) ? b : c);
+  }
+  ASSERT_EQ(dc.size(), 300);
+  ASSERT_EQ(dc.cardinality(), 3);
+  ASSERT(dc.is_missing(0));
+  ASSERT_EQ(dc.get(0), nullptr);
+  ASSERT(dc.get(3)->equals(a));
+  ASSERT(dc.get(4)->equals(b));
+  ASSERT_EQ(dc.code(3), dc.code(6));
+  ASSERT_NE(dc.code(3), dc.code(4));
+  ASSERT_EQ(dc.get(3), dc.get(6));
+
+  // Equal to a plain column with the same strings, and to its own clone.
+  StringColumn plain;
+  for (size_t i = 0; i < dc.size(); i++)
+    plain.push_back(dc.get(i));
+  ASSERT(dc.equals(&plain));
+  ASSERT(plain.equals(&dc));
+  DictStringColumn *copy = dc.clone();
+  ASSERT(dc.equals(copy));
+  copy->set(1, new String("Dave"));
+  ASSERT(!dc.equals(copy));
+  ASSERT_EQ(copy->cardinality(), 4);
+  delete copy;
+}
+
+TEST_F(ColumnTest, RepetitiveStringsAreDictionaryEncoded) {
+  StringColumn repetitive, distinct;
+  for (size_t i = 0; i < 1000; i++) {
+    repetitive.push_back((i % 2 == 0) ? a : b);
+    StrBuff sb;
+    sb.c("word").c(i);
+    distinct.push_back_steal_(sb.get());
+  }
+
+  Serializer rs, ds;
+  repetitive.serialize(rs);
+  distinct.serialize(ds);
+  ASSERT_LT(rs.length() * 3, ds.length());
+
+  Deserializer rd(*rs.data()), dd(*ds.data());
+  Column *r2 = Column::deserialize(rd);
+  Column *d2 = Column::deserialize(dd);
+  ASSERT_NE(dynamic_cast<DictStringColumn *>(r2), nullptr);
+  ASSERT_EQ(dynamic_cast<DictStringColumn *>(d2), nullptr);
+  ASSERT_EQ(r2->get_type(), 'S');
+  ASSERT(repetitive.equals(r2));
+  ASSERT(distinct.equals(d2));
+  delete r2;
+  delete d2;
+}
+
+TEST_F(ColumnTest, DictionaryEncodingGivesUpOverBudget) {
+  StringColumn sc, distinct;
+  for (size_t i = 0; i < 100; i++) {
+    StrBuff sb, db;
+    sb.c("a fairly long string number ").c(i % 40);
+    sc.push_back_steal_(sb.get());
+    db.c("hash ").c(i);
+    distinct.push_back_steal_(db.get());
+  }
+  ASSERT(sc.mostly_repeated_());
+  ASSERT_FALSE(distinct.mostly_repeated_());
+  DictStringColumn *dc = DictStringColumn::encode(&sc, 50);
+  ASSERT_EQ(dc->cardinality(), 40);
+  delete dc;
+  ASSERT_EQ(DictStringColumn::encode(&sc, 50, 500), nullptr);
+}
+
+TEST_F(ColumnTest, GetViewsTheArena) {
+  sc->push_back(a);
+  sc->push_back_missing();
+  sc->push_back(b);
+  String *view = sc->get(2);
+  ASSERT(view->equals(b));
+  ASSERT_EQ(view->c_str(), sc->chars_.data() + sc->offsets_.get(2));
+  ASSERT_EQ(sc->get(2), view); // each row keeps a single view
+  ASSERT_EQ(sc->get(1), nullptr);
+
+  String *set = new String("Dave");
+  sc->set(2, set);
+  ASSERT_EQ(sc->get(2), set);
+}
+
+TEST_F(ColumnTest, SetRowsAreSerialized) {
+  for (size_t i = 0; i < 1000; i++) {
+    sc->push_back(a);
+  }
+  for (size_t i = 0; i < 1000; i += 2) {
+    StrBuff sb;
+    sb.c("word").c(i);
+    sc->set(i, sb.get());
+  }
+  sc->set(1, nullptr);
+  StrBuff sb;
+  sb.c("word").c(998);
+  String *expected = sb.get();
+  ASSERT(sc->get(998)->equals(expected));
+  delete expected;
+  ASSERT(sc->get(999)->equals(a));
+
+  Serializer ser;
+  sc->serialize(ser);
+  Deserializer dser(*ser.data());
+  Column *sc2 = Column::deserialize(dser);
+  ASSERT(sc->equals(sc2));
+  ASSERT(sc2->is_missing(1));
+  delete sc2;
+}
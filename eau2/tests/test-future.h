@@ -0,0 +1,72 @@
+// lang: CwC
+#pragma once
+
+#include "../src/store/future.h"
+#include "test-macros.h"
+#include <gtest/gtest.h>
+
+/**
+ * @brief Future Unit Tests
+ * @author griep.p@husky.neu.edu, colabella.a@husky.neu.edu
+ */
+class FutureTest : public ::testing::Test {
+public:
+  Future f;
+};
+
+/** Counts how many times it has been called. **/
+class CountingCallback : public Callback {
+public:
+  size_t calls = 0;
+  void complete(Future *f) { calls++; }
+};
+
+/** Completes a future from another thread after a short delay. **/
+class Completer : public Thread {
+public:
+  Future *f_;
+  Completer(Future *f) : f_(f) {}
+  void run() {
+    Thread::sleep(10);
+    f_->complete(new Reply(new Key("k"), new Value(new Buffer())));
+  }
+};
+
+TEST_F(FutureTest, Poll) {
+  ASSERT(!f.ready());
+  f.complete(new Ack());
+  ASSERT(f.ready());
+  ASSERT(f.value() == nullptr);
+}
+
+TEST_F(FutureTest, WaitOnAnotherThread) {
+  Completer c(&f);
+  c.start();
+  Value *v = f.value();
+  ASSERT(v != nullptr);
+  ASSERT(f.ready());
+  c.join();
+}
+
+TEST_F(FutureTest, CallbackAfterCompletion) {
+  CountingCallback cb;
+  f.then(&cb);
+  ASSERT_EQ(cb.calls, 0);
+  f.complete(new Ack());
+  ASSERT_EQ(cb.calls, 1);
+}
+
+TEST_F(FutureTest, CallbackWhenAlreadyDone) {
+  CountingCallback cb;
+  f.complete(new Ack());
+  f.then(&cb);
+  ASSERT_EQ(cb.calls, 1);
+}
+
+TEST_F(FutureTest, StealValue) {
+  f.complete(new Reply(new Key("k"), new Value(new Buffer())));
+  Value *v = f.steal_value();
+  ASSERT(v != nullptr);
+  ASSERT(f.value() == nullptr);
+  delete v;
+}
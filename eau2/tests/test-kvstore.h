@@ -0,0 +1,84 @@
+// lang: CwC
+#pragma once
+
+#include "../src/client/application.h"
+#include "../src/client/network-pseudo.h"
+#include "test-macros.h"
+#include <gtest/gtest.h>
+
+/** A rower that counts rows, which can run where the rows are stored. **/
+class RowCounter : public RemoteRower {
+public:
+  size_t rows_ = 0;
+
+  const char *name() { return "row-counter"; }
+
+  bool accept(Row &r) {
+    rows_++;
+    return false;
+  }
+
+  void serialize(Serializer &ser) { ser.write(rows_); }
+  void restore(Deserializer &dser) { rows_ = dser.read_size_t(); }
+
+  void join_delete(Rower *other) {
+    rows_ += dynamic_cast<RowCounter *>(other)->rows_;
+    delete other;
+  }
+
+  RowCounter *clone() { return new RowCounter(); }
+};
+
+/** Node 0 stores a column of floats across every node, then counts its rows
+ * with owner_map, starting from a counter that already holds some. **/
+class OwnerMapApp : public Application {
+public:
+  static const size_t ROWS = 3 * CHUNK_SIZE + 5;
+  static const size_t START = 100;
+  size_t counted_ = 0;
+
+  OwnerMapApp(size_t idx, Network *net) : Application(idx, net) {
+    this_store()->registry()->add(new RowCounter());
+  }
+
+  void run_() override {
+    if (this_node() != 0)
+      return;
+    float *vals = new float[ROWS]();
+    Key key("owner-map", 0);
+    delete DataFrame::fromArray(&key, this_store(), ROWS, vals);
+    delete[] vals;
+
+    DataFrame *df = this_store()->get(&key);
+    RowCounter counter;
+    counter.rows_ = START;
+    df->owner_map(counter);
+    counted_ = counter.rows_;
+    delete df;
+    stop_all();
+  }
+};
+
+/** Runs an application on its own thread. **/
+class AppThread : public Thread {
+public:
+  Application *app_ = nullptr; // owned
+  ~AppThread() { delete app_; }
+  void run() { app_->start(); }
+};
+
+TEST(OwnerMapTest, StartStateIsCountedOnce) {
+  arg.num_nodes = 3;
+  Network *network = new NetworkPseudo(arg.num_nodes);
+  AppThread threads[3];
+  for (size_t i = 0; i < arg.num_nodes; i++) {
+    threads[i].app_ = new OwnerMapApp(i, network);
+    threads[i].start();
+  }
+  for (size_t i = 0; i < arg.num_nodes; i++) {
+    threads[i].join();
+  }
+  OwnerMapApp *master = dynamic_cast<OwnerMapApp *>(threads[0].app_);
+  ASSERT_EQ(master->counted_, OwnerMapApp::START + OwnerMapApp::ROWS);
+  delete network;
+}
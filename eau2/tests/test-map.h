@@ -1,6 +1,7 @@
 // lang: CwC
 #pragma once
 
+#include "../src/store/kvstore-fd.h"
 #include "../src/utils/map.h"
 #include "test-macros.h"
 #include <gtest/gtest.h>
@@ -79,3 +80,77 @@ TEST_F(MapTest, ExtensivePuts) {
 
   ASSERT_EQ(m.size(), 0);
 }
+
+/** Puts a range of keys into a concurrent map from its own thread. **/
+class KVPutter : public Thread {
+public:
+  ConcurrentKVMap *map_;
+  size_t start_, end_;
+
+  KVPutter(ConcurrentKVMap *map, size_t start, size_t end)
+      : map_(map), start_(start), end_(end) {}
+
+  void run() {
+    for (size_t i = start_; i < end_; i++) {
+      StrBuff sb;
+      sb.c("key").c(i);
+      Key k(sb.get(), i % 3);
+      map_->put(&k, new Value(new Buffer()));
+    }
+  }
+};
+
+TEST(ConcurrentKVMapTest, ShardedPutsFromManyThreads) {
+  ConcurrentKVMap map;
+  KVPutter a(&map, 0, 1000), b(&map, 1000, 2000), c(&map, 2000, 3000);
+  a.start();
+  b.start();
+  c.start();
+  a.join();
+  b.join();
+  c.join();
+
+  ASSERT_EQ(map.size(), 3000);
+  for (size_t i = 0; i < 3000; i++) {
+    StrBuff sb;
+    sb.c("key").c(i);
+    Key k(sb.get(), i % 3);
+    ASSERT(map.contains_key(&k));
+    delete map.remove(&k);
+  }
+  ASSERT_EQ(map.size(), 0);
+}
+
+TEST(SIMapTest, InterleavedPutsAndRemoves) {
+  SIMap m;
+  for (int i = 0; i < 5000; i++) {
+    StrBuff sb;
+    sb.c("k").c(i);
+    String *k = sb.get();
+    m.put(k, i);
+    m.put(k, i * 2);
+    delete k;
+  }
+  ASSERT_EQ(m.size(), 5000);
+
+  // Removing every third key shifts its neighbours back; the rest must still
+  // be found with their latest values.
+  for (int i = 0; i < 5000; i += 3) {
+    StrBuff sb;
+    sb.c("k").c(i);
+    String *k = sb.get();
+    ASSERT_EQ(m.remove(k), i * 2);
+    delete k;
+  }
+  for (int i = 0; i < 5000; i++) {
+    StrBuff sb;
+    sb.c("k").c(i);
+    String *k = sb.get();
+    ASSERT_EQ(m.contains_key(k), i % 3 != 0);
+    if (i % 3 != 0) {
+      ASSERT_EQ(m.get(k), i * 2);
+    }
+    delete k;
+  }
+  ASSERT_EQ(m.size(), 5000 - 1667);
+}
@@ -0,0 +1,139 @@
+// lang: CwC
+#pragma once
+
+#include "../src/store/dataframe.h"
+#include "../src/utils/pool.h"
+#include "test-macros.h"
+#include <gtest/gtest.h>
+
+/** Counts the morsels each slot runs, and how often each morsel runs. Morsel
+ * 0 waits until every other morsel has run, so the morsels queued behind it
+ * only finish if the other slots steal them. **/
+class CountingTask : public ParallelTask {
+public:
+  size_t n_;
+  std::atomic<size_t> *runs_;
+  std::atomic<size_t> done_{0};
+  bool gave_up_ = false; // whether morsel 0 stopped waiting for the others
+  size_t *per_slot_;
+
+  CountingTask(size_t n, size_t slots) : n_(n) {
+    runs_ = new std::atomic<size_t>[n];
+    for (size_t i = 0; i < n; i++)
+      runs_[i] = 0;
+    per_slot_ = new size_t[slots]();
+  }
+
+  ~CountingTask() {
+    delete[] runs_;
+    delete[] per_slot_;
+  }
+
+  void run(size_t m, size_t slot) {
+    for (size_t waited = 0; m == 0 && done_ + 1 < n_; waited++) {
+      if (waited == 5000) {
+        gave_up_ = true;
+        break;
+      }
+      Thread::sleep(1);
+    }
+    runs_[m]++;
+    done_++;
+    per_slot_[slot]++;
+  }
+};
+
+class ThreadPoolTest : public ::testing::Test {
+public:
+  static const size_t SLOTS = 4;
+  ThreadPool pool{SLOTS};
+};
+
+TEST_F(ThreadPoolTest, RunsEveryMorselOnce) {
+  size_t n = 1000;
+  for (size_t round = 0; round < 3; round++) {
+    CountingTask task(n, SLOTS);
+    pool.parallel_for(task, n);
+    size_t total = 0;
+    for (size_t i = 0; i < n; i++)
+      ASSERT_EQ(task.runs_[i], 1);
+    for (size_t i = 0; i < SLOTS; i++)
+      total += task.per_slot_[i];
+    ASSERT_EQ(total, n);
+    // The slot stuck on the slow morsel left the rest of its share to the
+    // others.
+    ASSERT_FALSE(task.gave_up_);
+  }
+}
+
+TEST_F(ThreadPoolTest, FewerMorselsThanSlots) {
+  CountingTask task(2, SLOTS);
+  pool.parallel_for(task, 2);
+  ASSERT_EQ(task.runs_[0], 1);
+  ASSERT_EQ(task.runs_[1], 1);
+  pool.parallel_for(task, 0);
+}
+
+/** A rower that sums its column and counts its rows. **/
+class SumRower : public Rower {
+public:
+  long sum_ = 0;
+  size_t rows_ = 0;
+
+  bool accept(Row &r) {
+    sum_ += r.get_int(0);
+    rows_++;
+    return true;
+  }
+
+  void join_delete(Rower *other) {
+    SumRower *that = dynamic_cast<SumRower *>(other);
+    sum_ += that->sum_;
+    rows_ += that->rows_;
+    delete other;
+  }
+
+  Rower *clone() { return new SumRower(); }
+};
+
+TEST(DataFramePoolTest, PmapOverManyChunks) {
+  Schema s("I");
+  DataFrame df(s);
+  Row r(df.get_schema());
+  size_t n = 5 * CHUNK_SIZE + 7;
+  long expected = 0;
+  for (size_t i = 0; i < n; i++) {
+    r.set(0, (int)i);
+    df.add_row(r);
+    expected += i;
+  }
+  SumRower sr;
+  df.pmap(sr);
+  ASSERT_EQ(sr.rows_, n);
+  ASSERT_EQ(sr.sum_, expected);
+}
+
+/** A rower that counts rows but cannot be cloned. **/
+class UnclonableRower : public Rower {
+public:
+  size_t rows_ = 0;
+
+  bool accept(Row &r) {
+    rows_++;
+    return true;
+  }
+};
+
+TEST(DataFramePoolTest, PmapRunsUnclonableRowerAlone) {
+  Schema s("I");
+  DataFrame df(s);
+  Row r(df.get_schema());
+  size_t n = 3 * CHUNK_SIZE;
+  for (size_t i = 0; i < n; i++) {
+    r.set(0, (int)i);
+    df.add_row(r);
+  }
+  UnclonableRower ur;
+  df.pmap(ur);
+  ASSERT_EQ(ur.rows_, n);
+}
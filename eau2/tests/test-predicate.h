@@ -0,0 +1,102 @@
+// lang: CwC
+#pragma once
+
+#include "../src/client/message.h"
+#include "../src/store/dataframe.h"
+#include "../src/store/predicate.h"
+#include "test-macros.h"
+#include <gtest/gtest.h>
+
+/**
+ * @brief Tests for predicates that are evaluated where a chunk is stored.
+ * @author griep.p@husky.neu.edu, colabella.a@husky.neu.edu
+ */
+class PredicateTest : public ::testing::Test {
+public:
+  Schema s{"IFS"};
+  Row row{s};
+
+  /** Fills the row with an int, a float and a string. **/
+  void fill(int i, float f, const char *str) {
+    row.set(0, i);
+    row.set(1, f);
+    row.set(2, new String(str));
+  }
+
+  /** 10 <= column 0 < 20, and column 2 is not "skip". **/
+  static Predicate *in_range() {
+    Predicate *low = new Predicate(PredKind::GreaterEq, 0, 10);
+    Predicate *high = new Predicate(PredKind::Less, 0, 20);
+    Predicate *name =
+        new Predicate(PredKind::NotEqual, 2, new String("skip"));
+    return new Predicate(PredKind::And, new Predicate(PredKind::And, low, high),
+                         name);
+  }
+};
+
+TEST_F(PredicateTest, ComparesEachType) {
+  fill(5, 2.5, "abc");
+  ASSERT(Predicate(PredKind::Equal, 0, 5).test(row));
+  ASSERT(Predicate(PredKind::Greater, 1, (float)2).test(row));
+  ASSERT(!Predicate(PredKind::LessEq, 1, (float)2).test(row));
+  ASSERT(Predicate(PredKind::Less, 2, new String("abd")).test(row));
+
+  Predicate either(PredKind::Or, new Predicate(PredKind::Equal, 0, 6),
+                   new Predicate(PredKind::Equal, 2, new String("abc")));
+  ASSERT(either.test(row));
+  row.set_missing(2);
+  ASSERT(!either.test(row));
+}
+
+TEST_F(PredicateTest, SerializesAsFilter) {
+  KeyArray *keys = new KeyArray();
+  keys->push_back(new Key("frame", 1));
+  Filter f1(keys, in_range());
+  f1.init(0, 1, 3);
+
+  Serializer ser;
+  ser.write(&f1);
+  Deserializer dser(*ser.data());
+  Filter *f2 = dynamic_cast<Filter *>(Message::from(dser));
+  ASSERT_EQ(f2->kind(), MsgKind::Filter);
+  ASSERT_EQ(f2->keys()->size(), 1);
+
+  fill(12, 0, "keep");
+  ASSERT(f2->pred()->test(row));
+  fill(12, 0, "skip");
+  ASSERT(!f2->pred()->test(row));
+  fill(20, 0, "keep");
+  ASSERT(!f2->pred()->test(row));
+  delete f2;
+}
+
+TEST_F(PredicateTest, FilterChunkKeepsMatchingRows) {
+  DataFrame df(s);
+  for (int i = 0; i < 100; i++) {
+    fill(i, i / 2.0, i % 2 == 0 ? "skip" : "keep");
+    df.add_row(row);
+  }
+  ValueArray columns;
+  for (size_t col = 0; col < df.ncols(); col++) {
+    Serializer ser;
+    ser.write(df.cols_.get(col));
+    columns.push_back(new Value(ser.steal()));
+  }
+
+  Predicate *pred = in_range();
+  ValueArray *kept = DataFrame::filter_chunk(&columns, *pred);
+  ASSERT_EQ(kept->size(), 3);
+  Deserializer dser(*kept->get(0)->blob());
+  IntColumn *ints = Column::deserialize(dser)->as_int();
+  ASSERT_EQ(ints->size(), 5); // 11, 13, 15, 17 and 19
+  ASSERT_EQ(ints->get(0), 11);
+  ASSERT_EQ(ints->get(4), 19);
+
+  delete ints;
+  delete pred;
+  for (size_t i = 0; i < columns.size(); i++) {
+    delete columns.get(i);
+    delete kept->get(i);
+  }
+  delete kept;
+}
@@ -101,3 +101,14 @@ TEST_F(RowTest, Reset) {
   delete s;
   delete q;
 }
+
+TEST_F(RowTest, ViewShowsCharactersWithoutCopying) {
+  char chars[] = "Carol";
+  r1->view(2, chars, 5);
+  ASSERT_FALSE(r1->get_missing(2));
+  ASSERT_EQ(r1->get_string(2)->c_str(), chars);
+  ASSERT_FALSE(r1->get_string(2)->equals(a));
+
+  r1->set(2, a->clone()); // a set string replaces the view
+  ASSERT(r1->get_string(2)->equals(a));
+}
@@ -34,3 +34,80 @@ public:
 };
 
 TEST_F(RowerTest, Accept) { ASSERT_FALSE(rr->accept(*r)); }
+
+/** Sums the ints and counts the true bools of a batch a column at a time,
+ * skipping missing values, and records where each batch starts. **/
+class ColumnSumRower : public Rower {
+public:
+  long ints_ = 0;
+  double floats_ = 0;
+  size_t trues_ = 0, batches_ = 0, rows_ = 0;
+
+  void accept_batch(Batch &batch) {
+    const int *ints = batch.ints(0);
+    const float *floats = batch.floats(1);
+    const size_t *missing = batch.missing_words(0);
+    const size_t *bools = batch.bool_words(2);
+    size_t bits = Bitset::WORD_BITS;
+    for (size_t i = 0; i < batch.size(); i++) {
+      if (((missing[i / bits] >> (i % bits)) & 1) == 0)
+        ints_ += ints[i];
+      floats_ += floats[i];
+    }
+    for (size_t w = 0; w < Bitset::words_for_(batch.size()); w++)
+      trues_ += __builtin_popcountl(bools[w]);
+    ASSERT_EQ(batch.start(), batches_ * CHUNK_SIZE);
+    batches_++;
+    rows_ += batch.size();
+  }
+};
+
+/** Builds a frame of an int with every seventh row missing, a float and a
+ * bool that is true on even rows, spanning a few chunks. **/
+static DataFrame *batch_frame(size_t n, long &ints, double &floats) {
+  Schema s("IFB");
+  DataFrame *df = new DataFrame(s);
+  Row r(s);
+  for (size_t i = 0; i < n; i++) {
+    if (i % 7 == 0) {
+      r.set_missing(0);
+    } else {
+      r.set(0, (int)i);
+      ints += i;
+    }
+    r.set(1, (float)1);
+    r.set(2, i % 2 == 0);
+    floats += 1;
+    df->add_row(r);
+  }
+  return df;
+}
+
+TEST(BatchTest, ColumnAtATime) {
+  long ints = 0;
+  double floats = 0;
+  size_t n = 2 * CHUNK_SIZE + 5;
+  DataFrame *df = batch_frame(n, ints, floats);
+  ColumnSumRower csr;
+  df->map(csr);
+  ASSERT_EQ(csr.batches_, 3);
+  ASSERT_EQ(csr.rows_, n);
+  ASSERT_EQ(csr.ints_, ints);
+  ASSERT_EQ(csr.floats_, floats);
+  ASSERT_EQ(csr.trues_, (n + 1) / 2);
+  delete df;
+}
+
+TEST(BatchTest, RowsAreAdaptedFromBatches) {
+  long ints = 0;
+  double floats = 0;
+  DataFrame *df = batch_frame(CHUNK_SIZE + 3, ints, floats);
+  Bitset all(3, true);
+  Batch batch(df->get_schema(), df->cols_, all, CHUNK_SIZE, CHUNK_SIZE, 3);
+  Row row(df->get_schema());
+  batch.fill_row(1, row);
+  ASSERT_EQ(row.get_idx(), CHUNK_SIZE + 1);
+  ASSERT_EQ(row.get_int(0), (int)CHUNK_SIZE + 1);
+  ASSERT_FALSE(row.get_bool(2));
+  delete df;
+}
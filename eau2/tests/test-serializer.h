@@ -143,7 +143,7 @@ TEST_F(SerializerTest, InformationalMethods) {
 }
 
 TEST_F(SerializerTest, FailOnBadCursor) {
-  Deserializer dser(new CharArray());
+  Deserializer dser(new Buffer());
   ASSERT_FAIL(dser.read_char());
 }
 
@@ -358,4 +358,137 @@ TEST_F(SerializerTest, MsgFrom) {
     ASSERT_EQ(d1.port(i), d2->port(i));
   }
   delete d2;
-}
\ No newline at end of file
+}
+TEST_F(SerializerTest, MultiPut) {
+  KeyArray *keys = new KeyArray();
+  ValueArray *values = new ValueArray();
+  for (size_t i = 0; i < 3; i++) {
+    StrBuff sb;
+    sb.c("key").c(i);
+    keys->push_back(new Key(sb.get(), i));
+    Buffer *blob = new Buffer();
+    for (size_t j = 0; j <= i; j++)
+      blob->push_back('a' + j);
+    values->push_back(new Value(blob));
+  }
+  MultiPut m1(keys, values);
+  m1.init(0, 2, 7);
+
+  ser.write(&m1);
+  Deserializer dser(*ser.data());
+  MultiPut *m2 = dynamic_cast<MultiPut *>(Message::from(dser));
+  ASSERT_EQ(m2->kind(), MsgKind::MultiPut);
+  ASSERT_EQ(m2->id_, 7);
+  ASSERT_EQ(m2->keys()->size(), 3);
+  for (size_t i = 0; i < 3; i++) {
+    ASSERT(m1.keys()->get(i)->equals(m2->keys()->get(i)));
+    ASSERT_EQ(m2->keys()->get(i)->node(), i);
+    ASSERT(m1.values()->get(i)->blob()->equals(m2->values()->get(i)->blob()));
+  }
+
+  Value *v = m2->steal_value(1);
+  ASSERT_EQ(v->size(), 2);
+  ASSERT_EQ(m2->values()->get(1), nullptr);
+  delete v;
+  delete m2;
+}
+
+TEST_F(SerializerTest, ChunkKey) {
+  Key base("frame", 1);
+  ChunkKey k1(base, 2, 5, 3);
+  Key plain("frame", 3);
+  ASSERT(!k1.equals(&plain) && !plain.equals(&k1));
+
+  ChunkKey *same = k1.clone();
+  ChunkKey other(base, 2, 6, 3);
+  ASSERT(k1.equals(same) && k1.hash() == same->hash());
+  ASSERT(!k1.equals(&other));
+  delete same;
+
+  KeyArray *keys = new KeyArray();
+  keys->push_back(k1.clone());
+  keys->push_back(plain.clone());
+  ValueArray *values = new ValueArray();
+  values->push_back(new Value(new Buffer("a", 1)));
+  values->push_back(new Value(new Buffer("b", 1)));
+  MultiPut m1(keys, values);
+  m1.init(0, 1, 0);
+
+  ser.write(&m1);
+  Deserializer dser(*ser.data());
+  MultiPut *m2 = dynamic_cast<MultiPut *>(Message::from(dser));
+  ChunkKey *k2 = m2->keys()->get(0)->as_chunk();
+  ASSERT(k2 != nullptr && k1.equals(k2));
+  ASSERT_EQ(k2->column(), 2);
+  ASSERT_EQ(k2->chunk(), 5);
+  ASSERT_EQ(k2->node(), 3);
+  ASSERT(plain.equals(m2->keys()->get(1)));
+  delete m2;
+}
+
+TEST_F(SerializerTest, ExecuteAndResult) {
+  Execute e1(new Key("frame", 0), new String("counter"));
+  e1.init(0, 2, 9);
+  ser.write(&e1);
+  Result r1(new Key("frame", 0), new Value(new Buffer("done", 4)));
+  r1.init(2, 0, 9);
+  ser.write(&r1);
+
+  Deserializer dser(*ser.data());
+  Execute *e2 = dynamic_cast<Execute *>(Message::from(dser));
+  ASSERT_EQ(e2->kind(), MsgKind::Execute);
+  ASSERT(e2->key()->equals(e1.key()));
+  ASSERT(e2->rower()->equals(e1.rower()));
+  Reply *r2 = dynamic_cast<Reply *>(Message::from(dser));
+  ASSERT_EQ(r2->kind(), MsgKind::Result);
+  ASSERT_EQ(r2->id_, 9);
+  ASSERT(r2->value()->blob()->equals(r1.value()->blob()));
+  delete e2;
+  delete r2;
+}
+
+TEST_F(SerializerTest, SharedValue) {
+  ser.write((size_t)42);
+  Value *v1 = new Value(ser.steal());
+  Value *v2 = v1->clone();
+  ASSERT_EQ(v1->blob(), v2->blob());
+
+  // Borrowing the bytes leaves them with the value.
+  {
+    Deserializer dser(*v2->blob());
+    ASSERT_EQ(dser.read_size_t(), 42);
+  }
+  ASSERT_EQ(v2->size(), sizeof(size_t));
+
+  // Stealing shared bytes copies them, stealing the last reference doesn't.
+  Buffer *copy = v1->steal();
+  ASSERT_NE(copy, v2->blob());
+  Buffer *last = v2->blob();
+  ASSERT_EQ(v2->steal(), last);
+  delete copy;
+  delete last;
+  delete v1;
+  delete v2;
+}
+
+TEST_F(SerializerTest, ContiguousBuffer) {
+  // Write well past a single array chunk and read it all back.
+  size_t len = CHUNK_SIZE * 3 + 7;
+  char *bytes = new char[len];
+  for (size_t i = 0; i < len; i++)
+    bytes[i] = 'a' + (i % 26);
+  ser.reserve(sizeof(size_t) + len);
+  size_t capacity = ser.data()->capacity_;
+  ser.write(len);
+  ser.write(bytes, len);
+  ASSERT_EQ(ser.data()->capacity_, capacity);
+  ASSERT_EQ(ser.length(), sizeof(size_t) + len);
+  ASSERT_EQ(ser.num_chunks(), 1);
+
+  Deserializer dser(*ser.data());
+  ASSERT_EQ(dser.read_size_t(), len);
+  char *read = dser.read_chars(len);
+  ASSERT_EQ(memcmp(bytes, read, len), 0);
+  delete[] bytes;
+  delete[] read;
+}
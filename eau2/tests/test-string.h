@@ -38,6 +38,39 @@ public:
 TEST_F(StringTest, HashInitializedToZero) { ASSERT_EQ(s1->hash_, 0); }
 TEST_F(StringTest, HashIsNotZero) { ASSERT_NE(s1->hash(), 0); }
 TEST_F(StringTest, HashConsistent) { ASSERT_EQ(s1->hash(), s1->hash()); }
+TEST_F(StringTest, EqualStringsHashEqually) {
+  ASSERT_EQ(s1->hash(), s2->hash());
+  ASSERT_NE(s1->hash(), s3->hash());
+}
+TEST_F(StringTest, HashIsCachedAndCopied) {
+  size_t h = s4->hash();
+  ASSERT_EQ(s4->hash_, h);
+  String *copy = s4->clone();
+  ASSERT_EQ(copy->hash_, h);
+  delete copy;
+}
+TEST_F(StringTest, ShortStringsAreInline) {
+  ASSERT_EQ(s1->c_str(), s1->inline_);
+  String *copy = s1->clone();
+  ASSERT_EQ(copy->c_str(), copy->inline_);
+  ASSERT(copy->equals(s1));
+  delete copy;
+
+  String longer("a string too long to fit inline");
+  ASSERT_NE(longer.c_str(), longer.inline_);
+  ASSERT_EQ(longer.size(), 31);
+}
+TEST_F(StringTest, StealInlineStringCopies) {
+  String *s = new String("word");
+  char *stolen = s->steal();
+  delete s;
+  ASSERT_EQ(strcmp(stolen, "word"), 0);
+  delete[] stolen;
+}
+TEST_F(StringTest, EmptyStringHashIsNotZero) {
+  String empty("");
+  ASSERT_NE(empty.hash(), 0);
+}
 TEST_F(StringTest, StringEqualsSameString) { ASSERT(s1->equals(s2)); }
 TEST_F(StringTest, StringDoesNotEqualOtherString) { ASSERT(!s3->equals(s1)); }
 TEST_F(StringTest, CharAtIsCorrect) { ASSERT_EQ(s1->at(1), 'e'); }
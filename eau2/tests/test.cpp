@@ -1,11 +1,18 @@
 #include <gtest/gtest.h>
 
 #include "test-array.h"
+#include "test-bitset.h"
+#include "test-bulk.h"
+#include "test-cache.h"
 #include "test-column.h"
 #include "test-dataframe.h"
+#include "test-future.h"
+#include "test-kvstore.h"
 #include "test-map.h"
 #include "test-object.h"
 #include "test-pmap.h"
+#include "test-pool.h"
+#include "test-predicate.h"
 #include "test-queue.h"
 #include "test-row.h"
 #include "test-rower.h"
@@ -14,6 +21,8 @@
 #include "test-string.h"
 #include "test-util.h"
 
+Arguments arg;
+
 int main(int argc, char **argv) {
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();